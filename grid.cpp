@@ -1,4 +1,6 @@
 #include <set>
+#include <cstdio>
+#include <mutex>
 #include <nana/gui.hpp>
 #include <nana/gui/widgets/checkbox.hpp>
 #include <nana/gui/widgets/group.hpp>
@@ -10,22 +12,90 @@ grid::grid( window wd, const rectangle& r)
     : listbox( wd, r )
     , myRowCount( 0 )
     , myColCount( 0 )
+    , myfModel( false )
 {
-
+    myFlushTimer.interval( 10 );
+    myFlushTimer.elapse([this]
+    {
+        Flush();
+    });
 }
 
 void grid::Resize( int rows, int cols )
 {
-    int newRows = rows - myRowCount;
-    int newCols = cols - myColCount;
+    // one layout and redraw for the whole change
+    auto_draw( false );
+
+    ResizeColumns( cols );
+
+    // the rows are the listbox model of the first category,
+    // the listbox asks for the cells of a row as it paints it
+    // so only the visible cells are ever formatted
+    if( rows && ! myfModel )
+    {
+        at( 0 ).shared_model< std::recursive_mutex >(
+            myRows,
+            []( const std::vector< listbox::cell >& )
+        {
+            // cells are not edited in the listbox
+            return 0;
+        },
+        [this]( const int& row )
+        {
+            std::vector< listbox::cell > cells;
+            for( int col = 0; col < myColCount; col++ )
+                cells.emplace_back( Format( myColumns[ col ], row ));
+            return cells;
+        });
+        myfModel = true;
+    }
+    if( myfModel )
+    {
+        auto guard = at( 0 ).model< std::recursive_mutex >();
+        auto& v = guard.container< std::vector< int > >();
+        v.resize( rows );
+        for( int krow = myRowCount; krow < rows; krow++ )
+            v[ krow ] = krow;
+    }
+
     myRowCount = rows;
-    myColCount = cols;
+    for( auto& c : myColumns )
+        Fit( c );
 
-    for( int kcol = 0; kcol < newCols; kcol++ )
+    auto_draw( true );
+}
+void grid::ResizeColumns( int cols )
+{
+    // columns are hidden rather than erased when shrinking
+    // and shown again when growing
+    int headers = column_size();
+    for( int kcol = headers; kcol < cols; kcol++ )
         append_header("c", 200);
+    for( int kcol = 0; kcol < headers; kcol++ )
+        column_at( kcol ).visible( kcol < cols );
 
-    for( int krow = 0; krow < newRows; krow++ )
-        at(0).append({"", ""});
+    myColCount = cols;
+    myColumns.resize( cols );
+    for( auto& c : myColumns )
+        Fit( c );
+}
+void grid::Fit( column_t& c )
+{
+    switch( c.type )
+    {
+    case eColumn::Int:
+        c.ints.resize( myRowCount );
+        break;
+    case eColumn::Dbl:
+        c.dbls.resize( myRowCount );
+        break;
+    case eColumn::Bool:
+        c.bools.resize( myRowCount );
+        break;
+    default:
+        c.strs.resize( myRowCount );
+        break;
+    }
 }
 void grid::ColTitle( int col, const std::string& value )
 {
@@ -39,8 +109,123 @@ void grid::Set( int row, int col, const std::string& value )
 {
     if( ! CheckIndex( row, col ) )
         return;
-    at(listbox::index_pair(0,row)).text(col,value);
+    column_t& c = myColumns[ col ];
+    if( c.type != eColumn::None && c.type != eColumn::Str )
+        return;
+    c.strs[ row ] = value;
+    myFlushTimer.start();
+}
 
+void grid::Set( int row, int col, const char * value )
+{
+    Set( row, col, std::string( value ));
+}
+
+// a single value does not change the type of a column,
+// which would reset the other rows
+void grid::Set( int row, int col, int value )
+{
+    if( ! CheckIndex( row, col ) )
+        return;
+    if( myColumns[ col ].type == eColumn::Dbl )
+    {
+        Set( row, col, (double)value );
+        return;
+    }
+    if( myColumns[ col ].type != eColumn::Int )
+        return;
+    Store( col, eColumn::Int, &column_t::ints, row, &value, 1 );
+}
+void grid::Set( int row, int col, double value )
+{
+    if( ! CheckIndex( row, col ) )
+        return;
+    if( myColumns[ col ].type != eColumn::Dbl )
+        return;
+    Store( col, eColumn::Dbl, &column_t::dbls, row, &value, 1 );
+}
+void grid::Set( int row, int col, bool value )
+{
+    if( ! CheckIndex( row, col ) )
+        return;
+    if( myColumns[ col ].type != eColumn::Bool )
+        return;
+    Store( col, eColumn::Bool, &column_t::bools, row, &value, 1 );
+}
+void grid::SetColumn( int col, const int * p, size_t n )
+{
+    if( ! CheckIndex( 0, col ) )
+        return;
+    Store( col, eColumn::Int, &column_t::ints, 0, p, n );
+}
+void grid::SetColumn( int col, const double * p, size_t n )
+{
+    if( ! CheckIndex( 0, col ) )
+        return;
+    Store( col, eColumn::Dbl, &column_t::dbls, 0, p, n );
+}
+void grid::SetColumn( int col, const bool * p, size_t n )
+{
+    if( ! CheckIndex( 0, col ) )
+        return;
+    Store( col, eColumn::Bool, &column_t::bools, 0, p, n );
+}
+void grid::SetColumn( int col, const std::vector< std::string >& values )
+{
+    if( ! CheckIndex( 0, col ) )
+        return;
+    Store( col, eColumn::Str, &column_t::strs, 0, values.data(), values.size() );
+}
+
+template < class T >
+void grid::Store(
+    int col,
+    eColumn type,
+    std::vector< T > column_t::* values,
+    int first,
+    const T * p,
+    size_t n )
+{
+    column_t& c = myColumns[ col ];
+
+    // column changing type, free the values of the old type
+    if( c.type != type )
+    {
+        c = column_t();
+        c.type = type;
+        Fit( c );
+    }
+
+    n = std::min( n, (size_t)( myRowCount - first ));
+    std::copy( p, p + n, ( c.*values ).begin() + first );
+
+    myFlushTimer.start();
+}
+
+std::string grid::Format( const column_t& c, int row )
+{
+    char buf[ 32 ];
+    switch( c.type )
+    {
+    case eColumn::Int:
+        snprintf( buf, sizeof( buf ), "%d", c.ints[ row ] );
+        return buf;
+    case eColumn::Dbl:
+        snprintf( buf, sizeof( buf ), "%g", c.dbls[ row ] );
+        return buf;
+    case eColumn::Bool:
+        return c.bools[ row ] ? "true" : "false";
+    default:
+        return c.strs[ row ];
+    }
+}
+
+void grid::Flush()
+{
+    myFlushTimer.stop();
+
+    // the listbox formats the visible cells as it paints
+    nana::API::refresh_window( *this );
 }
 
 bool grid::CheckIndex( int row, int col )
@@ -113,6 +298,20 @@ std::string options::Edit( window wd )
     return ValueAsString();
 }
 
+std::string element::Edit( window wd )
+{
+    inputbox::text value(
+        myName,
+        ValueAsString() );
+    inputbox inbox(wd,"Edit property value");
+    if( inbox.show_modal( value ) )
+    {
+        // store value
+        TrySetValue( value.value() );
+    }
+    return ValueAsString();
+}
+
 std::string truefalse::Edit( window wd )
 {
     inputbox::text value(
@@ -129,6 +328,13 @@ std::string truefalse::Edit( window wd )
 
 grid::grid( window wd, const rectangle& r)
     : nana::grid( wd, r )
+    , myVP( 0 )
+    , myPC( 0 )
+    , mySortBy( eSort::None )
+    , mySortDescending( false )
+    , myLazyBudget( 0 )
+    , myTick( 0 )
+    , myArrayPage( 100 )
 {
     Resize( 0, 2 );
     ColTitle(0,"Property");
@@ -144,25 +350,753 @@ grid::grid( window wd, const rectangle& r)
         if( sp.size() != 1 )
             return;
 
+        // property may have been removed from the external vector
+        prop_t p = find( sp[0] );
+        if( ! p )
+            return;
+
+        // click on array shows or hides its elements
+        auto arr = std::dynamic_pointer_cast< array_base >( p );
+        if( arr )
+        {
+            ToggleArray( arr );
+            return;
+        }
+        auto more = std::dynamic_pointer_cast< more_t >( p );
+        if( more )
+        {
+            auto a = more->myArray.lock();
+            if( a )
+                ExpandArray( a );
+            return;
+        }
+
+        // computed properties cannot be edited,
+        // and reading the value here would run an async getter on the GUI thread
+        if( std::dynamic_pointer_cast< computed >( p ) )
+            return;
+
         // Edit selected property and display new value
-        at(sp[0]).text(
-            1,
-            myVP->at( at(sp[0]).value<int>() )->Edit( wd ));
+        std::string before = p->ValueAsString();
+        std::string after = p->Edit( wd );
+        if( after == before )
+        {
+            // edit cancelled or value unchanged, nothing to recalculate
+            return;
+        }
+        at(sp[0]).text( 1, after );
 
+        // keep edited properties of lazy category from being released
+        auto lazy = myLazy.find( sp[0].cat );
+        if( lazy != myLazy.end() )
+            lazy->second.cat->Edited();
+
+        // array element edited, continue with the array
+        auto elem = std::dynamic_pointer_cast< element >( p );
+        if( elem )
+        {
+            auto a = elem->Array();
+            auto it = myRow.find( a.get() );
+            if( ! a || it == myRow.end() )
+                return;
+            p = find( it->second );
+            at( it->second ).text( 1, Text( p.get() ) );
+        }
+
+        // keep sorted
+        Reposition( p.get() );
+
+        // recalculate and display derived properties
+        if( myPC )
+            myPC->Changed( p );
+
+    });
+
+    // check lazy categories and computed properties for user expanding them
+    myTimer.interval( 100 );
+    myTimer.elapse([this]
+    {
+        Poll();
     });
 }
 
+grid::~grid()
+{
+    if( myPC )
+        myPC->Listen( nullptr );
+}
+
+prop_t grid::find( const index_pair& ip )
+{
+    return myHandles.Get( at( ip ).value< handle >() );
+}
+
+void grid::Insert(
+    const prop_t& prop,
+    const std::string& category_name,
+    int position )
+{
+    if( prop->Type() == eType::Cat )
+        throw std::runtime_error(
+            "property:grid.Insert() cannot insert category" );
+    for( auto& p : *myVP )
+        if( *p == prop->myName )
+            throw std::runtime_error(
+                "property:grid.Insert() Two properties have same name: " + prop->myName );
+
+    // first property of the category in the external vector
+    size_t catIndex = 0;
+    auto it_vp = myVP->begin();
+    if( category_name.size() )
+    {
+        it_vp = std::find_if(
+                    myVP->begin(),
+                    myVP->end(),
+                    [&category_name]( const prop_t& p )
+        {
+            return p->Type() == eType::Cat && *p == category_name;
+        });
+        if( it_vp == myVP->end() )
+            throw std::runtime_error(
+                "property:grid.Insert() category not found: " + category_name );
+        if( myLazy.count( (*it_vp)->category_index() ) )
+            throw std::runtime_error(
+                "property:grid.Insert() cannot insert into lazy category: " + category_name );
+        catIndex = (*it_vp)->category_index();
+        it_vp++;
+    }
+
+    // element rows are not counted in positions
+    CollapseArrays( catIndex );
+    size_t count = at( catIndex ).size();
+    if( position < 0 || position > (int)count )
+        position = count;
+    index_pair row( catIndex, position );
+
+    // insert before the property displayed at the position,
+    // otherwise after the last property in the category
+    auto it_next = myVP->end();
+    if( position < (int)count )
+        it_next = std::find( myVP->begin(), myVP->end(), find( row ) );
+    if( it_next == myVP->end() )
+        it_next = std::find_if(
+                      it_vp,
+                      myVP->end(),
+                      []( const prop_t& p )
+    {
+        return p->Type() == eType::Cat;
+    });
+
+    myVP->insert( it_next, prop );
+    if( myPC )
+        myPC->Reindex();
+
+    // make room in the category
+    Shift( row, 1 );
+
+    insert_item( row, prop->myLabel );
+    at( row ).value( myHandles.Add( prop ) );
+    Display( row, prop );
+    if( myComputed.size() || myLive.size() || myCompareComputed.size() )
+        myTimer.start();
+
+    // keep sorted
+    Reposition( prop.get() );
+}
+
+void grid::Remove( const std::string& name )
+{
+    auto it_vp = std::find_if(
+                     myVP->begin(),
+                     myVP->end(),
+                     [&name]( const prop_t& p )
+    {
+        return *p == name;
+    });
+    if( it_vp == myVP->end() )
+        return;
+    CollapseArray( std::dynamic_pointer_cast< array_base >( *it_vp ));
+    auto it_row = myRow.find( it_vp->get() );
+    if( it_row == myRow.end() )
+        return;
+    EraseRows( { it_row->second } );
+
+    myVP->erase( it_vp );
+    if( myPC )
+        myPC->Reindex();
+}
+
+void grid::EraseRows( std::vector< index_pair > rows )
+{
+    std::sort( rows.begin(), rows.end() );
+
+    // erase from the last, so positions of rows still to be erased are unchanged
+    for( auto it = rows.rbegin(); it != rows.rend(); it++ )
+    {
+        handle h = at( *it ).value< handle >();
+        Forget( myHandles.Address( h ) );
+        myHandles.Remove( h );
+        erase( at( *it ) );
+    }
+
+    // renumber a stored row to account for the erased rows before it
+    // returns true if the row itself was erased
+    auto renumber = [&rows]( index_pair& r )
+    {
+        auto first = std::lower_bound( rows.begin(), rows.end(), index_pair( r.cat, 0 ));
+        auto it = std::lower_bound( first, rows.end(), r );
+        if( it != rows.end() && *it == r )
+            return true;
+        r.item -= it - first;
+        return false;
+    };
+    for( auto it = myRow.begin(); it != myRow.end(); )
+    {
+        if( renumber( it->second ) )
+            it = myRow.erase( it );
+        else
+            it++;
+    }
+    std::vector< computed_t > kept;
+    for( auto& c : myComputed )
+        if( ! renumber( c.row ) )
+            kept.push_back( std::move( c ));
+    myComputed.swap( kept );
+    myLive.erase(
+        std::remove_if(
+            myLive.begin(),
+            myLive.end(),
+            [this]( const prop_t& p )
+    {
+        return ! myRow.count( p.get() );
+    }),
+    myLive.end() );
+}
+
+void grid::Forget( property_base * p )
+{
+    myKeys.erase( p );
+    myHighlighted.erase( p );
+}
+
+diff_t grid::Highlight(
+    property_container& baseline,
+    bool fOnlyDifferences,
+    unsigned threads )
+{
+    if( ! myPC )
+        throw std::runtime_error(
+            "property:grid.Highlight() grid not set from property container" );
+
+    diff_t diff = Diff( baseline, *myPC, threads );
+
+    auto_draw( false );
+
+    // clear previous highlights
+    for( auto& h : myHighlighted )
+    {
+        auto it = myRow.find( h.first );
+        if( it != myRow.end() )
+            at( it->second ).bgcolor( bgcolor() );
+    }
+    myHighlighted.clear();
 
+    for( auto& name : diff.changed )
+        myHighlighted[ myPC->find( name ).get() ] = nana::color( 255, 255, 160 );
+    for( auto& name : diff.added )
+        myHighlighted[ myPC->find( name ).get() ] = nana::color( 200, 255, 200 );
+    for( auto& h : myHighlighted )
+    {
+        auto it = myRow.find( h.first );
+        if( it != myRow.end() )
+            at( it->second ).bgcolor( h.second );
+    }
+
+    if( fOnlyDifferences )
+    {
+        CollapseArrays();
+        std::vector< index_pair > same;
+        for( auto& r : myRow )
+            if( ! myHighlighted.count( r.first ) )
+                same.push_back( r.second );
+        EraseRows( same );
+    }
+
+    auto_draw( true );
+
+    return diff;
+}
+
+void grid::Sort( eSort by, bool fDescending )
+{
+    mySortBy = by;
+    mySortDescending = fDescending;
+    myKeys.clear();
+    if( mySortBy == eSort::None )
+        return;
+    auto_draw( false );
+    for( size_t c = 0; c < size_categ(); c++ )
+        SortCategory( c );
+    auto_draw( true );
+}
+
+void grid::SortCategory( size_t catIndex )
+{
+    if( mySortBy == eSort::None )
+        return;
+
+    CollapseArrays( catIndex );
+
+    auto cat = at( catIndex );
+    std::vector< std::pair< prop_t, handle > > rows;
+    for( size_t k = 0; k < cat.size(); k++ )
+    {
+        handle h = cat.at( k ).value< handle >();
+        rows.push_back( std::make_pair( myHandles.Get( h ), h ));
+    }
+
+    std::stable_sort(
+        rows.begin(),
+        rows.end(),
+        [this]( const std::pair< prop_t, handle >& a,
+                const std::pair< prop_t, handle >& b )
+    {
+        return Less( a.first.get(), b.first.get() );
+    });
+
+    for( size_t k = 0; k < rows.size(); k++ )
+        WriteRow( index_pair( catIndex, k ), rows[ k ].first, rows[ k ].second );
+    for( auto& c : myComputed )
+        if( c.row.cat == catIndex )
+            c.row = myRow[ c.prop.get() ];
+}
+
+void grid::Reposition( property_base * p )
+{
+    if( mySortBy == eSort::None )
+        return;
+
+    // new value, new key
+    myKeys.erase( p );
+
+    auto it = myRow.find( p );
+    if( it == myRow.end() )
+        return;
+
+    // nothing to do if still in order with its neighbours,
+    // so expanded arrays in the category stay expanded
+    if( ! IsOutOfOrder( it->second ) )
+        return;
+
+    CollapseArrays( it->second.cat );
+    index_pair row = it->second;
+    size_t count = at( row.cat ).size();
+
+    // property at position k in the category, skipping the repositioned property
+    auto other = [&]( size_t k )
+    {
+        return myHandles.Get(
+                   at( index_pair( row.cat, k < row.item ? k : k + 1 ) ).value< handle >() ).get();
+    };
+
+    // binary search for new position among the other, still sorted, properties
+    size_t lo = 0;
+    size_t hi = count - 1;
+    while( lo < hi )
+    {
+        size_t mid = ( lo + hi ) / 2;
+        if( Less( p, other( mid ) ) )
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    if( lo == row.item )
+        return;
+
+    // move the properties in between by one row
+    handle h = at( row ).value< handle >();
+    prop_t moved = myHandles.Get( h );
+    int step = lo < row.item ? -1 : 1;
+    for( size_t k = row.item; k != lo; k += step )
+    {
+        handle hk = at( index_pair( row.cat, k + step ) ).value< handle >();
+        WriteRow( index_pair( row.cat, k ), myHandles.Get( hk ), hk );
+    }
+    WriteRow( index_pair( row.cat, lo ), moved, h );
+    for( auto& c : myComputed )
+        if( c.row.cat == row.cat )
+            c.row = myRow[ c.prop.get() ];
+}
+
+bool grid::IsOutOfOrder( const index_pair& row )
+{
+    property_base * p = find( row ).get();
+
+    // element rows follow their array and are not sorted
+    auto sorted = [this]( const prop_t& q )
+    {
+        return ! std::dynamic_pointer_cast< element >( q )
+               && ! std::dynamic_pointer_cast< more_t >( q );
+    };
+
+    size_t count = at( row.cat ).size();
+    for( size_t k = row.item; k > 0; k-- )
+    {
+        prop_t prev = find( index_pair( row.cat, k - 1 ));
+        if( ! sorted( prev ) )
+            continue;
+        if( Less( p, prev.get() ) )
+            return true;
+        break;
+    }
+    for( size_t k = row.item + 1; k < count; k++ )
+    {
+        prop_t next = find( index_pair( row.cat, k ));
+        if( ! sorted( next ) )
+            continue;
+        return Less( next.get(), p );
+    }
+    return false;
+}
+
+void grid::WriteRow(
+    const index_pair& row,
+    const prop_t& prop,
+    handle h )
+{
+    auto item = at( row );
+    item.value( h );
+    if( ! prop )
+    {
+        // property removed from external vector
+        item.text( 0, "" );
+        item.text( 1, "" );
+        return;
+    }
+    item.text( 0, prop->myLabel );
+    item.text( 1, Text( prop.get() ) );
+    auto it = myHighlighted.find( prop.get() );
+    item.bgcolor( it == myHighlighted.end() ? bgcolor() : it->second );
+    myRow[ prop.get() ] = row;
+    CompareRow( row, prop );
+}
+
+bool grid::Less( property_base * a, property_base * b )
+{
+    if( mySortDescending )
+        std::swap( a, b );
+    return Key( a ) < Key( b );
+}
+
+const grid::sort_key& grid::Key( property_base * p )
+{
+    auto it = myKeys.find( p );
+    if( it != myKeys.end() )
+        return it->second;
+
+    sort_key& key = myKeys[ p ];
+    key.fNumber = false;
+    key.number = 0;
+    if( ! p )
+        return key;
+    switch( mySortBy )
+    {
+    case eSort::Name:
+        key.text = p->myName;
+        break;
+    case eSort::Label:
+        key.text = p->myLabel;
+        break;
+    default:
+        key.fNumber = p->ValueAsNumber( key.number );
+        if( ! key.fNumber )
+            key.text = Text( p );
+        break;
+    }
+    return key;
+}
+
+void grid::ToggleArray( const std::shared_ptr< array_base >& a )
+{
+    if( myExpanded.count( a ) )
+        CollapseArray( a );
+    else
+        ExpandArray( a );
+}
+
+void grid::ExpandArray( const std::shared_ptr< array_base >& a )
+{
+    auto it = myRow.find( a.get() );
+    if( it == myRow.end() )
+        return;
+    index_pair row = it->second;
+
+    // array resized since its elements were shown, start again
+    auto old = myExpanded.find( a );
+    if( old != myExpanded.end() && old->second.size != a->size() )
+        CollapseArray( a );
+
+    expanded_t& x = myExpanded[ a ];
+    x.size = a->size();
+    x.address = a.get();
+    size_t first = x.elements.size();
+    size_t count = std::min( myArrayPage, a->size() - first );
+    bool fMore = first + count < a->size();
+    index_pair pos( row.cat, row.item + 1 + first );
+
+    auto_draw( false );
+
+    // the new page replaces the previous "more" row
+    if( x.more )
+    {
+        EraseRows( { pos } );
+        x.more.reset();
+    }
+
+    Shift( pos, count + fMore );
+    for( size_t k = 0; k < count; k++ )
+    {
+        prop_t e( new element( a, first + k ));
+        x.elements.push_back( e );
+        InsertRow( index_pair( pos.cat, pos.item + k ), e );
+    }
+    if( fMore )
+    {
+        x.more = prop_t( new more_t( a ));
+        InsertRow( index_pair( pos.cat, pos.item + count ), x.more );
+    }
+
+    auto_draw( true );
+}
+
+void grid::CollapseArray( const array_ref& a )
+{
+    auto x = myExpanded.find( a );
+    if( x == myExpanded.end() )
+        return;
+    auto it = myRow.find( x->second.address );
+    if( it != myRow.end() )
+    {
+        // the element rows follow the array row
+        size_t count = x->second.elements.size() + ( x->second.more ? 1 : 0 );
+        std::vector< index_pair > rows;
+        for( size_t k = 1; k <= count; k++ )
+            rows.push_back( index_pair( it->second.cat, it->second.item + k ));
+        EraseRows( rows );
+    }
+    myExpanded.erase( x );
+}
+
+void grid::RefreshArray( const prop_t& p )
+{
+    auto a = std::dynamic_pointer_cast< array_base >( p );
+    if( ! a )
+        return;
+    auto x = myExpanded.find( a );
+    if( x == myExpanded.end() )
+        return;
+    if( x->second.size != a->size() )
+    {
+        CollapseArray( a );
+        return;
+    }
+    auto it = myRow.find( a.get() );
+    if( it == myRow.end() )
+        return;
+
+    // the element rows follow the array row
+    auto& elements = x->second.elements;
+    for( size_t k = 0; k < elements.size(); k++ )
+        at( index_pair( it->second.cat, it->second.item + 1 + k ))
+        .text( 1, Text( elements[ k ].get() ) );
+}
+
+void grid::CollapseArrays( size_t catIndex )
+{
+    std::vector< array_ref > arrays;
+    for( auto& x : myExpanded )
+    {
+        auto it = myRow.find( x.second.address );
+        if( catIndex == (size_t)-1 || ( it != myRow.end() && it->second.cat == catIndex ))
+            arrays.push_back( x.first );
+    }
+    for( auto& a : arrays )
+        CollapseArray( a );
+}
+
+void grid::InsertRow( const index_pair& row, const prop_t& prop )
+{
+    insert_item( row, prop->myLabel );
+    at( row ).value( myHandles.Add( prop ) );
+    at( row ).text( 1, prop->ValueAsString() );
+}
+
+void grid::Compare(
+    const std::vector< property_container* >& others,
+    const std::vector< std::string >& titles )
+{
+    myCompare = others;
+    for( auto c : myCompare )
+        c->Index();
+
+    auto_draw( false );
+    ResizeColumns( 2 + myCompare.size() );
+    for( int k = 0; k < (int)myCompare.size(); k++ )
+    {
+        ColTitle( 2 + k, k < (int)titles.size() ? titles[ k ] : "" );
+        ColWidth( 2 + k, 100 );
+    }
+    for( auto& r : myRow )
+    {
+        prop_t p = find( r.second );
+        if( p )
+            CompareRow( r.second, p );
+    }
+    auto_draw( true );
+    if( myCompareComputed.size() )
+        myTimer.start();
+}
+
+void grid::CompareRow(
+    const index_pair& row,
+    const prop_t& prop )
+{
+    auto item = at( row );
+    for( int k = 0; k < (int)myCompare.size(); k++ )
+    {
+        prop_t other = myCompare[ k ]->find( prop->myName );
+        if( ! other )
+        {
+            item.text( 2 + k, "" );
+            continue;
+        }
+        auto comp = std::dynamic_pointer_cast< computed >( other );
+        if( comp && ! comp->IsValid() && comp->IsAsync() )
+        {
+            CompareAsync( comp, myCompare[ k ], prop );
+            item.text( 2 + k, "..." );
+            continue;
+        }
+        // compared containers are not polled, so calculate now
+        item.text( 2 + k, other->ValueAsString() );
+    }
+}
+
+void grid::CompareAsync(
+    const std::shared_ptr< computed >& other,
+    property_container * container,
+    const prop_t& shown )
+{
+    for( auto& c : myCompareComputed )
+    {
+        if( c.prop == other )
+        {
+            // already calculating, display in the current row when done
+            c.shown = shown;
+            return;
+        }
+    }
+    compare_t c;
+    c.prop = other;
+    c.container = container;
+    c.shown = shown;
+    c.generation = other->Generation();
+    c.calculating = std::async( std::launch::async, other->Getter() );
+    myCompareComputed.push_back( std::move( c ));
+}
+
+size_t grid::Memory()
+{
+    size_t bytes = sizeof( *this );
+
+    // listbox items
+    size_t cols = column_size();
+    bytes += cols * ( sizeof( std::string ) + sizeof( unsigned ));
+    for( size_t c = 0; c < size_categ(); c++ )
+    {
+        auto cat = at( c );
+        bytes += sizeof( std::string ) + HeapMemory( cat.text() );
+        for( size_t k = 0; k < cat.size(); k++ )
+        {
+            auto item = cat.at( k );
+
+            // the stored handle, its holder and the cell vector
+            bytes += sizeof( handle ) + 4 * sizeof( void* );
+            for( size_t col = 0; col < cols; col++ )
+                bytes += sizeof( std::string ) + HeapMemory( item.text( col ) );
+        }
+    }
+
+    // bookkeeping, each hash table node holds a next pointer
+    bytes += myRow.bucket_count() * sizeof( void* )
+             + myRow.size() * ( sizeof( void* ) + sizeof( std::pair< property_base*, index_pair > ));
+    bytes += myHandles.Memory() - sizeof( myHandles );
+    bytes += myHighlighted.bucket_count() * sizeof( void* )
+             + myHighlighted.size() * ( sizeof( void* ) + sizeof( std::pair< property_base*, nana::color > ));
+    bytes += myKeys.bucket_count() * sizeof( void* );
+    for( auto& k : myKeys )
+        bytes += sizeof( void* ) + sizeof( k ) + HeapMemory( k.second.text );
+    bytes += myComputed.capacity() * sizeof( computed_t );
+    bytes += myCompareComputed.capacity() * sizeof( compare_t );
+    bytes += myLive.capacity() * sizeof( prop_t );
+    bytes += myLazy.size() * ( sizeof( lazy_t ) + 3 * sizeof( void* ));
+    for( auto& x : myExpanded )
+    {
+        // tree node holds three links and a colour
+        bytes += 4 * sizeof( void* ) + sizeof( x ) + HeapMemory( x.second.elements );
+        if( x.second.more )
+            bytes += theControlBlockMemory + x.second.more->Memory();
+    }
+
+    return bytes;
+}
+
+void grid::Shift( const index_pair& row, int delta )
+{
+    for( auto& r : myRow )
+        if( r.second.cat == row.cat && r.second.item >= row.item )
+            r.second.item += delta;
+    for( auto& c : myComputed )
+        if( c.row.cat == row.cat && c.row.item >= row.item )
+            c.row.item += delta;
+}
+
+
+
+void grid::Set( property_container& pc )
+{
+    Set( pc.get() );
+    myPC = &pc;
+    myPC->Listen( [this]( const vector_t& changed )
+    {
+        Refresh( changed );
+    });
+}
 
 void grid::Set( vector_t& v )
 {
+    if( myPC )
+        myPC->Listen( nullptr );
+    myPC = 0;
     myVP = &v;
+    myLazy.clear();
+    myComputed.clear();
+    myRow.clear();
+    myLive.clear();
+    myExpanded.clear();
+    myHighlighted.clear();
+    myKeys.clear();
+    myHandles.clear();
+
+    // remove rows and categories displayed by a previous call
+    auto_draw( false );
+    clear();
+    erase();
 
     // maintain a set of property names
     // used to enforce unique names
     std::set< std::string > NameSet;
 
-    int propIndex = 0;
     int catIndex = 0;
     auto cat = at(0);
     for( auto& prop : *myVP )
@@ -182,17 +1116,29 @@ void grid::Set( vector_t& v )
                 // store category index in property
                 catIndex++;
                 prop->category_index( catIndex );
+
+                // lazy categories start collapsed and empty
+                // their properties are created when the user expands them
+                auto lazy = std::dynamic_pointer_cast< category >( prop );
+                if( lazy && lazy->IsLazy() )
+                {
+                    cat.expanded( false );
+                    myLazy[ catIndex ].cat = lazy;
+                    if( lazy->IsLoaded() )
+                        Fill( catIndex, myLazy[ catIndex ] );
+                }
             }
             else
             {
                 // add new item to current category
                 cat.push_back(prop->myLabel);
-                cat.back().text(1,prop->ValueAsString());
+                Display( cat.back().pos(), prop );
 
-                // store the index of the property in the external vector
+                // store a handle to the property
                 // as the assocaited value of the listbox item
                 // so that it can be easily recovered when user clicks on property
-                cat.back().value( propIndex );
+                // even after properties are inserted or removed
+                cat.back().value( myHandles.Add( prop ) );
             }
         }
         else
@@ -200,10 +1146,296 @@ void grid::Set( vector_t& v )
             std::stringstream ss;
             ss << "property:grid.Set() Two properties have same name: ";
             ss << name;
+            auto_draw( true );
             throw std::runtime_error( ss.str() );
         }
+    }
+
+    Sort( mySortBy, mySortDescending );
+
+    auto_draw( true );
+
+    if( myLazy.size() || myComputed.size() || myLive.size() || myCompareComputed.size() )
+        myTimer.start();
+    else
+        myTimer.stop();
+}
+
+void grid::Fill( int catIndex, lazy_t& lazy )
+{
+    auto cat = at( catIndex );
+    for( auto& prop : lazy.cat->Children() )
+    {
+        cat.push_back( prop->myLabel );
+        Display( cat.back().pos(), prop );
+        cat.back().value( myHandles.Add( prop ) );
+    }
+    SortCategory( catIndex );
+}
+
+void grid::Display( const index_pair& row, const prop_t& prop )
+{
+    myRow[ prop.get() ] = row;
+    at( row ).text( 1, Text( prop.get() ) );
+    CompareRow( row, prop );
+
+    if( prop->IsLive() )
+    {
+        prop->Updated();
+        myLive.push_back( prop );
+    }
+
+    auto comp = std::dynamic_pointer_cast< computed >( prop );
+    if( ! comp )
+        return;
+
+    // do not call getter yet, the category may never be expanded
+    computed_t c;
+    c.prop = comp;
+    c.row = row;
+    myComputed.push_back( std::move( c ));
+}
+
+std::string grid::Text( property_base * p )
+{
+    auto comp = dynamic_cast< computed* >( p );
+    if( comp && ! comp->IsValid() )
+        return "...";
+    return p->ValueAsString();
+}
+
+void grid::Refresh( const vector_t& changed )
+{
+    auto_draw( false );
+    for( auto& p : changed )
+    {
+        auto it = myRow.find( p.get() );
+        if( it == myRow.end() )
+            continue;
+        at( it->second ).text( 1, Text( p.get() ) );
+        RefreshArray( p );
+        Reposition( p.get() );
+    }
+    auto_draw( true );
+}
+
+void grid::Invalidate( const std::string& name )
+{
+    for( auto& c : myComputed )
+    {
+        if( *c.prop == name )
+        {
+            c.prop->Invalidate();
+            at( c.row ).text( 1, "..." );
+            break;
+        }
+    }
+    Poll();
+}
+
+void grid::Poll()
+{
+    PollLazy();
+    PollComputed();
+    PollLive();
+    PollCompare();
+}
+
+void grid::PollCompare()
+{
+    for( auto& c : myCompareComputed )
+    {
+        if( c.calculating.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+            continue;
+        if( ! c.prop->Cache( c.calculating.get(), c.generation ) )
+        {
+            // invalidated while getter ran, value is stale so start again
+            c.generation = c.prop->Generation();
+            c.calculating = std::async( std::launch::async, c.prop->Getter() );
+            continue;
+        }
+
+        // display unless the row has gone or the container is no longer compared
+        auto shown = c.shown.lock();
+        auto it = myRow.find( shown.get() );
+        if( ! shown || it == myRow.end() )
+            continue;
+        for( int k = 0; k < (int)myCompare.size(); k++ )
+            if( myCompare[ k ] == c.container )
+                at( it->second ).text( 2 + k, c.prop->ValueAsString() );
+    }
+    myCompareComputed.erase(
+        std::remove_if(
+            myCompareComputed.begin(),
+            myCompareComputed.end(),
+            []( const compare_t& c )
+    {
+        return ! c.calculating.valid();
+    }),
+    myCompareComputed.end() );
+}
+
+void grid::PollLive()
+{
+    // collect updated properties first,
+    // moving rows can erase element rows and so change myLive
+    vector_t updated;
+    for( auto& p : myLive )
+    {
+        if( ! p->Updated() )
+            continue;
+        auto it = myRow.find( p.get() );
+        if( it == myRow.end() )
+            continue;
+        at( it->second ).text( 1, p->ValueAsString() );
+        updated.push_back( p );
+    }
+    if( ! updated.size() )
+        return;
+    auto_draw( false );
+    for( auto& p : updated )
+    {
+        RefreshArray( p );
+        Reposition( p.get() );
+    }
+    auto_draw( true );
+}
+
+void grid::PollComputed()
+{
+    // reposition after the loop,
+    // moving rows can erase element rows and so change myComputed
+    vector_t calculated;
+    for( auto& c : myComputed )
+    {
+        if( c.calculating.valid() )
+        {
+            // getter running on worker thread
+            // display the value when it is done
+            if( c.calculating.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+                continue;
+            if( c.prop->Cache( c.calculating.get(), c.generation ) )
+            {
+                at( c.row ).text( 1, c.prop->ValueAsString() );
+                calculated.push_back( c.prop );
+                continue;
+            }
+            // invalidated while getter ran, value is stale so start again
+        }
+        if( c.prop->IsValid() )
+            continue;
+        if( ! at( c.row.cat ).expanded() )
+            continue;
+
+        if( c.prop->IsAsync() )
+        {
+            auto getter = c.prop->Getter();
+            c.generation = c.prop->Generation();
+            c.calculating = std::async( std::launch::async, getter );
+        }
+        else
+        {
+            at( c.row ).text( 1, c.prop->ValueAsString() );
+            calculated.push_back( c.prop );
+        }
+    }
+    for( auto& p : calculated )
+        Reposition( p.get() );
+}
+
+void grid::PollLazy()
+{
+    myTick++;
+    size_t loaded = 0;
+    for( auto& l : myLazy )
+    {
+        auto& lazy = l.second;
+        bool expanded = at( l.first ).expanded();
+
+        if( lazy.loading.valid() )
+        {
+            // provider running on worker thread
+            // display the properties when it is done
+            if( lazy.loading.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+            {
+                lazy.cat->Loaded( lazy.loading.get() );
+                Fill( l.first, lazy );
+            }
+        }
+        else if( expanded && ! lazy.cat->IsLoaded() )
+        {
+            if( lazy.cat->IsAsync() )
+            {
+                auto provider = lazy.cat->Provider();
+                lazy.loading = std::async(
+                                   std::launch::async,
+                                   [provider]
+                {
+                    vector_t v;
+                    provider( v );
+                    return v;
+                });
+            }
+            else
+            {
+                lazy.cat->Load();
+                Fill( l.first, lazy );
+            }
+        }
 
-        propIndex++;
+        if( expanded )
+            lazy.lastExpanded = myTick;
+        loaded += HeapMemory( lazy.cat->Children() );
+    }
+
+    if( ! myLazyBudget )
+        return;
+
+    // release least recently expanded collapsed categories until within budget
+    while( loaded > myLazyBudget )
+    {
+        auto oldest = myLazy.end();
+        for( auto it = myLazy.begin(); it != myLazy.end(); it++ )
+        {
+            if( ! it->second.cat->IsReleasable() || it->second.lastExpanded == myTick )
+                continue;
+            if( oldest == myLazy.end() || it->second.lastExpanded < oldest->second.lastExpanded )
+                oldest = it;
+        }
+        if( oldest == myLazy.end() )
+            break;
+        loaded -= HeapMemory( oldest->second.cat->Children() );
+        int catIndex = oldest->first;
+        CollapseArrays( catIndex );
+        auto cat = at( catIndex );
+        for( size_t k = 0; k < cat.size(); k++ )
+        {
+            handle h = cat.at( k ).value< handle >();
+            property_base * p = myHandles.Address( h );
+            myRow.erase( p );
+            Forget( p );
+            myHandles.Remove( h );
+        }
+        myComputed.erase(
+            std::remove_if(
+                myComputed.begin(),
+                myComputed.end(),
+                [catIndex]( const computed_t& c )
+        {
+            return (int)c.row.cat == catIndex;
+        }),
+        myComputed.end() );
+        myLive.erase(
+            std::remove_if(
+                myLive.begin(),
+                myLive.end(),
+                [this]( const prop_t& p )
+        {
+            return ! myRow.count( p.get() );
+        }),
+        myLive.end() );
+        clear( catIndex );
+        oldest->second.cat->Release();
     }
 }
 void  grid::Collapse(
@@ -217,6 +1449,9 @@ void  grid::Collapse(
         {
             at( p->category_index() ).expanded( ! fCollapse );
 
+            // load lazy category now rather than waiting for timer
+            Poll();
+
             break;
         }
         row++;
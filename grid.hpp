@@ -1,7 +1,15 @@
 #pragma once
+#include <climits>
+#include <cerrno>
 #include <map>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <thread>
+#include <type_traits>
 #include <nana/gui/widgets/panel.hpp>
 #include <nana/gui/widgets/listbox.hpp>
+#include <nana/gui/timer.hpp>
 #include "properties.hpp"
 
 namespace nana
@@ -19,7 +27,14 @@ public:
     */
     grid( window wd, const rectangle& r = rectangle());
 
-    /** Resize the grid */
+    /** Resize the grid
+        @param[in] rows number of rows
+        @param[in] cols number of columns
+
+        The grid is redrawn once, however many rows and columns change.
+        Columns removed by shrinking are hidden,
+        and shown again if the grid grows.
+    */
     void Resize( int rows, int cols );
 
     /** Title the column
@@ -34,27 +49,117 @@ public:
     */
     void ColWidth( int col, int width );
 
-    /** Set cell value */
+    /** Set cell value
+        @param[in] row zero-based row index
+        @param[in] col zero-based column index
+        @param[in] value
+
+        Ignored if the column holds numbers or booleans, set by SetColumn()
+    */
     void Set( int row, int col, const std::string& value );
+    void Set( int row, int col, const char * value );
+
+    /** Set cell value in a typed column
+        @param[in] row zero-based row index
+        @param[in] col zero-based column index
+        @param[in] value
+
+        The column must already hold values of the same type, set by SetColumn(),
+        except that an int can be set in a column of doubles.
+        Otherwise the value is ignored.
+        The new value is shown when the grid is next flushed
+    */
+    void Set( int row, int col, int value );
+    void Set( int row, int col, double value );
+    void Set( int row, int col, bool value );
+
+    /** Set values of a typed column
+        @param[in] col zero-based column index
+        @param[in] p pointer to values, one per row from the first
+        @param[in] n number of values
+
+        The values are stored in a contiguous array for the column,
+        which takes the type of the values.
+        The listbox formats cells as it paints them, so only visible cells are formatted,
+        and many updates before the grid is next flushed cost one repaint.
+    */
+    void SetColumn( int col, const int * p, size_t n );
+    void SetColumn( int col, const double * p, size_t n );
+    void SetColumn( int col, const bool * p, size_t n );
+    void SetColumn( int col, const std::vector< std::string >& values );
+
+    /** Repaint the grid to show values that have been set
+
+    This is called automatically soon after values are set,
+    call it to see the new values immediately.
+    */
+    void Flush();
 
 protected:
     int myRowCount;
     int myColCount;
 
+    /** Change number of columns, leaving the rows unchanged
+        @param[in] cols number of columns
+    */
+    void ResizeColumns( int cols );
+
     /** true if row and col are included */
     bool CheckIndex( int row, int col );
 
+private:
+
+    /** Value types of typed columns */
+    enum class eColumn
+    {
+        None,       // cells set as strings with Set( row, col, std::string ), held in strs
+        Int,
+        Dbl,
+        Bool,
+        Str,
+    };
+
+    /// typed values of a column
+    struct column_t
+    {
+        eColumn type = eColumn::None;
+        std::vector< int > ints;
+        std::vector< double > dbls;
+        std::vector< bool > bools;
+        std::vector< std::string > strs;
+    };
+
+    std::vector< column_t > myColumns;
+
+    /// row indices, the listbox model of the first category
+    std::vector< int > myRows;
+
+    /// true once the rows are the listbox model, after the first Resize() with rows
+    bool myfModel;
+
+    /// flushes changed values soon after they are set
+    nana::timer myFlushTimer;
 
+    /** Size values of column to number of rows */
+    void Fit( column_t& c );
+
+    /** Store values in typed column */
+    template < class T >
+    void Store(
+        int col,
+        eColumn type,
+        std::vector< T > column_t::* values,
+        int first,
+        const T * p,
+        size_t n );
+
+    /** Format value of typed column */
+    std::string Format( const column_t& c, int row );
 };
 
 namespace prop
 {
 
-
-/** vector of pointers to properties */
-typedef std::shared_ptr< property_base > prop_t;
-typedef std::vector< prop_t > vector_t;
-
 /** Property grid for handling name/value pairs */
 
 class grid : public nana::grid
@@ -62,6 +167,8 @@ class grid : public nana::grid
 public:
     grid( window wd, const rectangle& r = rectangle());
 
+    ~grid();
+
     /** Add properties vector vector
         @param[in] v vector of properties
 
@@ -75,10 +182,13 @@ public:
      */
     void Set( vector_t& v );
 
-    void Set( property_container& pc )
-    {
-        Set( pc.get() );
-    }
+    /** Add properties container
+
+        As Set( vector_t& ), and in addition the grid listens to the container
+        so that properties changed through the container are redisplayed,
+        and property edits in the grid recalculate derived properties.
+    */
+    void Set( property_container& pc );
 
     /** Collapse or expand a category
 
@@ -89,6 +199,139 @@ public:
         const std::string& category_name,
         bool fCollapse = true );
 
+    /** Limit memory used by lazy categories
+        @param[in] bytes used by properties created by providers,
+                   as measured by HeapMemory(), 0 for no limit
+
+    When the limit is exceeded the properties of the collapsed lazy categories
+    that were expanded least recently are released.
+    They will be created again if the category is expanded.
+
+    Categories with edited properties are released only if they have a saver,
+    see property_container::AddLazy().
+    */
+    void LazyMemoryBudget( size_t bytes )
+    {
+        myLazyBudget = bytes;
+    }
+
+    /** Set how often the grid checks for lazy categories being expanded,
+        computed values being calculated and live values being updated
+        @param[in] ms interval in milliseconds, default 100
+    */
+    void PollInterval( unsigned ms )
+    {
+        myTimer.interval( ms );
+    }
+
+    /** Set number of array elements shown each time the user asks for more
+        @param[in] count of elements, default 100
+    */
+    void ArrayPage( size_t count )
+    {
+        myArrayPage = count ? count : 1;
+    }
+
+    /** Discard cached value of computed property
+
+    @param[in] name of computed property
+
+    The value will be calculated again if the property is in an expanded category
+    */
+    void Invalidate( const std::string& name );
+
+    /** Insert property into grid and external vector
+        @param[in] prop property to insert
+        @param[in] category_name category to insert into, "" for the properties before the first category
+        @param[in] position zero-based row in the category to insert at, default -1 for the end
+
+        The grid is not rebuilt.
+        Computed and live properties are polled as if they had been in the vector from the start.
+        A sorted category keeps its order, so the property may not stay at position.
+        Properties cannot be inserted into lazy categories.
+    */
+    void Insert(
+        const prop_t& prop,
+        const std::string& category_name = "",
+        int position = -1 );
+
+    /** Remove property from grid and external vector
+        @param[in] name of property to remove
+
+        The grid is not rebuilt
+    */
+    void Remove( const std::string& name );
+
+    /** Highlight differences from a baseline
+        @param[in] baseline container to compare with
+        @param[in] fOnlyDifferences true to remove rows that do not differ from the grid
+        @param[in] threads number of worker threads to compare with, see Diff()
+        @return the differences
+
+        The grid must have been set from a property container.
+        Changed properties are highlighted yellow, added properties green.
+        Properties only in the baseline have no row,
+        they are reported in the returned differences.
+        Call Set() again to restore rows that were removed.
+
+        Computed properties are calculated to be compared,
+        those whose getters are not async always on the calling thread.
+    */
+    diff_t Highlight(
+        property_container& baseline,
+        bool fOnlyDifferences = false,
+        unsigned threads = 1 );
+
+    /** Show values of other configurations in extra columns
+        @param[in] others containers with the same property names as the displayed properties
+        @param[in] titles of the extra columns
+
+        Values are looked up by property name,
+        a property missing from a container shows a blank value.
+        The containers must not go out of scope before the grid,
+        call again with an empty vector to stop comparing.
+    */
+    void Compare(
+        const std::vector< property_container* >& others,
+        const std::vector< std::string >& titles = std::vector< std::string >() );
+
+    /** Get memory used by grid
+        @return estimated bytes used by the listbox items and the grid's bookkeeping
+
+        The listbox is measured through its interface,
+        so its internal overhead per item is estimated.
+        The displayed properties are not included, see property_container::Memory(),
+        except array elements created by the grid.
+    */
+    size_t Memory();
+
+    /** Property sort orders */
+    enum class eSort
+    {
+        None,       // order of external vector
+        Name,
+        Label,
+        Value,      // numeric order for integer and real properties
+    };
+
+    /** Sort properties within each category
+        @param[in] by sort order
+        @param[in] fDescending true for descending order
+
+        Array elements shown in a category are hidden when it is sorted.
+
+        The sort keys are cached.
+        When a property value is edited, through the grid or a property container,
+        its key is recalculated and its row moved to its new position,
+        the category is not sorted again.
+
+        eSort::None leaves the rows in their current order,
+        call Set() again to restore the order of the external vector.
+    */
+    void Sort(
+        eSort by,
+        bool fDescending = false );
+
     /** Change value of existing property */
 //    void Set(
 //        const std::string& name,
@@ -103,9 +346,239 @@ public:
 
 private:
 
+    /// lazy category displayed in the grid
+    struct lazy_t
+    {
+        std::shared_ptr< category > cat;
+        std::future< vector_t > loading;    ///< valid while provider runs on worker thread
+        unsigned lastExpanded;              ///< tick when category was last seen expanded
+    };
+
+    /// computed property displayed in the grid
+    struct computed_t
+    {
+        std::shared_ptr< computed > prop;
+        index_pair row;
+        std::future< std::string > calculating;    ///< valid while getter runs on worker thread
+        unsigned generation;                        ///< of property when getter started
+    };
+
     /// pointer to external property vector
     vector_t * myVP;
 
+    /// pointer to external property container, if displaying one
+    property_container * myPC;
+
+    /// listbox item displaying each property
+    std::unordered_map< property_base*, index_pair > myRow;
+
+    /// handles to displayed properties, stored as the values of listbox items
+    handle_table myHandles;
+
+    /// properties highlighted as differing from a baseline, with highlight colour
+    std::unordered_map< property_base*, nana::color > myHighlighted;
+
+    /// sort key, numeric for integer and real values
+    struct sort_key
+    {
+        bool fNumber;
+        double number;
+        std::string text;
+
+        bool operator<( const sort_key& other ) const
+        {
+            // numbers sort before text
+            if( fNumber != other.fNumber )
+                return fNumber;
+            if( fNumber )
+                return number < other.number;
+            return text < other.text;
+        }
+    };
+
+    eSort mySortBy;
+    bool mySortDescending;
+
+    /// cached sort keys
+    std::unordered_map< property_base*, sort_key > myKeys;
+
+    /// lazy categories, keyed by category index
+    std::map< int, lazy_t > myLazy;
+
+    std::vector< computed_t > myComputed;
+
+    /// displayed properties whose values can change outside the application
+    vector_t myLive;
+
+    size_t myLazyBudget;
+    unsigned myTick;
+
+    /// row following the shown elements of an array, click to show more
+    class more_t : public property_base
+    {
+    public:
+        more_t( const std::shared_ptr< array_base >& a )
+            : property_base( a->myName + "...", "  ...", eType::Str )
+            , myArray( a )
+        {
+
+        }
+        std::string ValueAsString() const
+        {
+            return "more";
+        }
+        void SetValue( const std::string& sv )
+        {}
+        bool TrySetValue( const std::string& sv )
+        {
+            return false;
+        }
+        std::string Edit( nana::window wd )
+        {
+            return ValueAsString();
+        }
+
+        std::weak_ptr< array_base > myArray;
+    };
+
+    /// array whose elements are shown
+    struct expanded_t
+    {
+        vector_t elements;      ///< element properties shown, following the array row
+        prop_t more;            ///< row following the elements, if not all shown
+        size_t size = 0;        ///< array size when the elements were shown
+        array_base * address;   ///< of array, to find its row after it is destroyed
+    };
+
+    /// arrays whose elements are shown
+    /// keyed by weak pointer, so a destroyed array is not confused with a new one at the same address
+    typedef std::weak_ptr< array_base > array_ref;
+    std::map< array_ref, expanded_t, std::owner_less< array_ref > > myExpanded;
+
+    size_t myArrayPage;
+
+    /// containers whose values are displayed in extra columns
+    std::vector< property_container* > myCompare;
+
+    /// computed property of a compared container, calculating on a worker thread
+    struct compare_t
+    {
+        std::shared_ptr< computed > prop;
+        property_container * container;             ///< holding prop
+        std::weak_ptr< property_base > shown;       ///< displayed property with the same name
+        std::future< std::string > calculating;
+        unsigned generation;                        ///< of prop when getter started
+    };
+    std::vector< compare_t > myCompareComputed;
+
+    /// polls lazy categories and computed properties for expansion and completed work
+    nana::timer myTimer;
+
+    /** Get property displayed at listbox item
+        @return pointer to property, empty if removed
+    */
+    prop_t find( const index_pair& ip );
+
+    /** Erase listbox items, releasing their handles and renumbering stored rows */
+    void EraseRows( std::vector< index_pair > rows );
+
+    /** Discard sort key and highlight of property no longer displayed,
+        so a new property at the same address does not inherit them
+    */
+    void Forget( property_base * p );
+
+    /** Sort properties in category */
+    void SortCategory( size_t catIndex );
+
+    /** Move property, whose value has changed, to its sorted position in its category */
+    void Reposition( property_base * p );
+
+    /** true if property displayed in row is not in sorted order with its neighbours */
+    bool IsOutOfOrder( const index_pair& row );
+
+    /** Display property in listbox item */
+    void WriteRow(
+        const index_pair& row,
+        const prop_t& prop,
+        handle h );
+
+    /** true if property a sorts before property b */
+    bool Less( property_base * a, property_base * b );
+
+    /** Get sort key of property, from cache if available */
+    const sort_key& Key( property_base * p );
+
+    /** Show array elements if hidden, otherwise hide them */
+    void ToggleArray( const std::shared_ptr< array_base >& a );
+
+    /** Show next page of array elements */
+    void ExpandArray( const std::shared_ptr< array_base >& a );
+
+    /** Hide array elements */
+    void CollapseArray( const array_ref& a );
+
+    /** Update shown array elements after the array changes
+
+    The elements are hidden if the array has changed size since they were shown,
+    otherwise the shown element values are rewritten.
+    */
+    void RefreshArray( const prop_t& p );
+
+    /** Hide elements of arrays in category, default all categories */
+    void CollapseArrays( size_t catIndex = (size_t)-1 );
+
+    /** Display values of compared containers in listbox item
+
+    Computed properties of the containers are calculated,
+    async ones on a worker thread with a placeholder displayed until done.
+    */
+    void CompareRow(
+        const index_pair& row,
+        const prop_t& prop );
+
+    /** Start calculating computed property of compared container on worker thread */
+    void CompareAsync(
+        const std::shared_ptr< computed >& other,
+        property_container * container,
+        const prop_t& shown );
+
+    /** Insert listbox item displaying property */
+    void InsertRow( const index_pair& row, const prop_t& prop );
+
+    /** Move stored rows at or after row in same category by delta items */
+    void Shift( const index_pair& row, int delta );
+
+    /** Check lazy categories and computed properties */
+    void Poll();
+
+    /** Check lazy categories, loading those expanded and releasing those over budget */
+    void PollLazy();
+
+    /** Check computed properties, calculating those in expanded categories */
+    void PollComputed();
+
+    /** Check live properties, redisplaying those updated */
+    void PollLive();
+
+    /** Check computed properties of compared containers, displaying those calculated */
+    void PollCompare();
+
+    /** Display property value in listbox item, polling it if computed or live
+        computed properties display a placeholder until calculated
+    */
+    void Display( const index_pair& row, const prop_t& prop );
+
+    /** Get text to display for property value
+        computed properties display a placeholder until calculated
+    */
+    std::string Text( property_base * p );
+
+    /** Redisplay property values that have changed */
+    void Refresh( const vector_t& changed );
+
+    /** Display the properties created by provider */
+    void Fill( int catIndex, lazy_t& lazy );
+
 };
 }
 }
@@ -96,6 +96,22 @@ void Read( prop::property_container& pc )
     pc.Add( "F", 0.42 );
     pc.AddBool( "G", "the G factor", false );
     pc.Add( "Plan", { "A","B","C"} );
+    pc.AddArray( "J", "samples", std::vector< double > { 0.1, 0.5, 0.2, 0.9 } );
+    pc.AddDerived( "E+F", [&pc]
+    {
+        std::stringstream ss;
+        ss << atof( pc.find( "E" )->ValueAsString().c_str() )
+           + atof( pc.find( "F" )->ValueAsString().c_str() );
+        return ss.str();
+    },
+    { "E", "F" } );
+
+    // category whose properties are created when user expands it
+    pc.AddLazy( "lazy category", []( vector_t& v )
+    {
+        v.emplace_back( prop_t( new integer( "H", 1 )));
+        v.emplace_back( prop_t( new real( "I", 2.5 )));
+    });
 }
 
 /** Save properties
@@ -0,0 +1,278 @@
+#pragma once
+#include <fstream>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "grid.hpp"
+
+namespace nana
+{
+namespace prop
+{
+
+/** Library of named sets of property values for a property container
+
+The values of a preset are resolved against the container when added,
+so applying a preset needs no name lookups or string parsing for numeric values.
+Applying writes only the values that differ from the current values,
+then a grid displaying the container redisplays only those.
+
+Presets are resolved to positions in the container,
+so add them again after inserting or removing properties.
+Values for properties that have moved are reported as errors when applied.
+*/
+
+class preset_library
+{
+public:
+
+    typedef property_container::apply_error apply_error;
+
+    /** CTOR
+        @param[in] pc container the presets apply to,
+                      must not go out of scope before the library
+    */
+    preset_library( property_container& pc )
+        : myPC( pc )
+    {
+
+    }
+
+    /** Add preset, replacing any preset with the same name
+        @param[in] preset name of preset
+        @param[in] values ( property name, value ) pairs
+        @return entries that could not be resolved
+    */
+    std::vector< apply_error > Add(
+        const std::string& preset,
+        const std::vector< std::pair< std::string, std::string > >& values )
+    {
+        std::vector< apply_error > errors;
+        std::vector< entry >& entries = myPresets[ preset ];
+        entries.clear();
+        for( int k = 0; k < (int)values.size(); k++ )
+        {
+            entry e;
+            std::string error;
+            if( Resolve( values[ k ].first, values[ k ].second, e, error ))
+                entries.push_back( e );
+            else
+                errors.push_back( { k, error } );
+        }
+        return errors;
+    }
+
+    /** Load presets from a file
+        @param[in] path to file
+        @return entries that could not be resolved, index is line number from 1
+
+        The file is memory mapped and parsed in place. Format:
+<pre>
+[preset name]
+property name=value
+property name=value
+[another preset name]
+...
+</pre>
+        Blank lines and lines starting with # are ignored.
+    */
+    std::vector< apply_error > Load( const std::string& path )
+    {
+        using namespace boost::interprocess;
+        std::vector< apply_error > errors;
+
+        // an empty file cannot be mapped, and holds no presets
+        std::ifstream size( path, std::ios::binary | std::ios::ate );
+        if( size && size.tellg() == 0 )
+            return errors;
+
+        file_mapping file( path.c_str(), read_only );
+        mapped_region region( file, read_only );
+        const char * p = static_cast< const char* >( region.get_address() );
+        const char * end = p + region.get_size();
+
+        std::vector< entry > * entries = 0;
+        std::string error;
+        int line = 0;
+        while( p < end )
+        {
+            line++;
+            const char * eol = std::find( p, end, '\n' );
+            const char * last = eol;
+            if( last > p && *( last - 1 ) == '\r' )
+                last--;
+
+            if( p == last || *p == '#' )
+            {
+                // blank or comment
+            }
+            else if( *p == '[' && *( last - 1 ) == ']' )
+            {
+                entries = &myPresets[ std::string( p + 1, last - 1 ) ];
+                entries->clear();
+            }
+            else
+            {
+                const char * eq = std::find( p, last, '=' );
+                entry e;
+                if( ! entries )
+                    errors.push_back( { line, "value before first preset name" } );
+                else if( eq == last )
+                    errors.push_back( { line, "missing =" } );
+                else if( Resolve( std::string( p, eq ), std::string( eq + 1, last ), e, error ))
+                    entries->push_back( e );
+                else
+                    errors.push_back( { line, error } );
+            }
+            p = eol + 1;
+        }
+        return errors;
+    }
+
+    /** Get names of presets */
+    std::vector< std::string > Names() const
+    {
+        std::vector< std::string > names;
+        for( auto& p : myPresets )
+            names.push_back( p.first );
+        return names;
+    }
+
+    /** Apply preset
+        @param[in] preset name of preset
+        @param[out] count number of property values changed, if not null
+        @return entries that could not be applied, index is position in preset,
+                a single entry with index -1 if preset not found
+    */
+    std::vector< apply_error > Apply(
+        const std::string& preset,
+        int * count = 0 )
+    {
+        std::vector< apply_error > errors;
+        if( count )
+            *count = 0;
+        auto it = myPresets.find( preset );
+        if( it == myPresets.end() )
+        {
+            errors.push_back( { -1, "preset not found: " + preset } );
+            return errors;
+        }
+        vector_t& props = myPC.get();
+        vector_t changed;
+        for( int k = 0; k < (int)it->second.size(); k++ )
+        {
+            entry& e = it->second[ k ];
+
+            // the property resolved must still be at the same position
+            if( e.slot >= (int)props.size()
+                    || e.prop.owner_before( props[ e.slot ] )
+                    || props[ e.slot ].owner_before( e.prop ) )
+            {
+                errors.push_back( { k, "property moved or removed, add preset again: " + e.name } );
+                continue;
+            }
+            prop_t& p = props[ e.slot ];
+            if( e.fNumber )
+            {
+                double v;
+                if( p->ValueAsNumber( v ) && v == e.number )
+                    continue;
+                if( ! p->SetNumber( e.number ))
+                {
+                    errors.push_back( { k, "invalid value for " + e.name } );
+                    continue;
+                }
+            }
+            else
+            {
+                if( p->ValueAsString() == e.text )
+                    continue;
+                if( ! p->TrySetValue( e.text ))
+                {
+                    errors.push_back( { k, "invalid value for " + e.name + ": " + e.text } );
+                    continue;
+                }
+            }
+            changed.push_back( p );
+        }
+        myPC.Changed( changed );
+        if( count )
+            *count = changed.size();
+        return errors;
+    }
+
+private:
+
+    /// value resolved against the container
+    struct entry
+    {
+        std::string name;
+        int slot;               ///< position of property in container
+        std::weak_ptr< property_base > prop;    ///< property at slot when resolved
+        bool fNumber;           ///< true for numeric properties
+        double number;
+        std::string text;       ///< value of non-numeric properties
+    };
+
+    property_container& myPC;
+    std::map< std::string, std::vector< entry > > myPresets;
+
+    bool Resolve(
+        const std::string& name,
+        const std::string& value,
+        entry& e,
+        std::string& error )
+    {
+        e.name = name;
+        e.slot = myPC.Slot( name );
+        if( e.slot < 0 )
+        {
+            error = "property not found: " + name;
+            return false;
+        }
+        prop_t& p = myPC.get()[ e.slot ];
+        e.prop = p;
+        double v;
+        e.fNumber = p->ValueAsNumber( v );
+        if( e.fNumber )
+        {
+            char * end;
+            e.number = strtod( value.c_str(), &end );
+            if( end == value.c_str() || *end )
+            {
+                error = "invalid value for " + name + ": " + value;
+                return false;
+            }
+
+            // an integer property would truncate the value,
+            // so it would never compare equal and be written on every apply
+            if( p->Type() == eType::Int
+                    && ( e.number != (int)e.number || e.number < INT_MIN || e.number > INT_MAX ))
+            {
+                error = "invalid value for " + name + ": " + value;
+                return false;
+            }
+        }
+        else
+        {
+            // check now, as numbers are, rather than fail on every apply
+            bool fValid;
+            auto options = p->Options();
+            if( p->Type() == eType::Bool )
+                fValid = ( value == "true" || value == "false" );
+            else if( options.size() )
+                fValid = std::find( options.begin(), options.end(), value ) != options.end();
+            else
+                fValid = true;
+            if( ! fValid )
+            {
+                error = "invalid value for " + name + ": " + value;
+                return false;
+            }
+            e.text = value;
+        }
+        return true;
+    }
+};
+
+}
+}
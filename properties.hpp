@@ -2,6 +2,22 @@ namespace nana
 {
 namespace prop
 {
+/** Heap memory used by a string
+    @return bytes allocated, 0 if the characters are stored within the string object
+*/
+inline size_t HeapMemory( const std::string& s )
+{
+    const char * object = reinterpret_cast< const char* >( &s );
+    if( s.data() >= object && s.data() < object + sizeof( s ))
+        return 0;
+    return s.capacity() + 1;
+}
+
+/** Estimated size of the control block allocated by a shared_ptr
+    constructed from a pointer: vtable, two reference counts and the pointer
+*/
+const size_t theControlBlockMemory = 2 * sizeof( void* ) + 2 * sizeof( int );
+
 /** Property types supported */
 enum class eType
 {
@@ -11,6 +27,7 @@ enum class eType
     Bool,       // boolean
     Enm,        // choice of strings
     Cat,        // category divider
+    Arr,        // array of numbers
 };
 
 /** Property base class
@@ -54,6 +71,19 @@ public:
     */
     virtual void SetValue( const std::string& sv ) = 0;
 
+    /** Set option value from a string, if the string is a valid value
+        @param[in] sv value as string
+        @return false if sv is not a valid value, property is unchanged
+
+        By default any string is valid.
+        Properties with restricted values override this.
+    */
+    virtual bool TrySetValue( const std::string& sv )
+    {
+        SetValue( sv );
+        return true;
+    }
+
     /** Edit option value
         @return new value as string
 
@@ -73,6 +103,42 @@ public:
         return myType;
     }
 
+    /** Get value as a number
+        @param[out] v the value
+        @return false if the property does not have a numeric value
+
+        Numeric properties override this, so values can be compared without parsing strings.
+    */
+    virtual bool ValueAsNumber( double& v ) const
+    {
+        return false;
+    }
+
+    /** Set value from a number
+        @param[in] v the value
+        @return false if the property does not have a numeric value
+
+        Numeric properties override this, so values can be set without formatting strings.
+    */
+    virtual bool SetNumber( double v )
+    {
+        return false;
+    }
+
+    /** true if the value can change outside the application,
+        so a grid displaying the property should poll Updated()
+    */
+    virtual bool IsLive() const
+    {
+        return false;
+    }
+
+    /** true if the value has changed since the last call */
+    virtual bool Updated()
+    {
+        return false;
+    }
+
     /** Get the options
         @return vector of option strings
 
@@ -91,6 +157,16 @@ public:
         return ( myName == name );
     }
 
+    /** Get memory used by property
+        @return bytes used by the property object and its heap allocations
+
+        Specialized properties override this to add their own members.
+    */
+    virtual size_t Memory() const
+    {
+        return sizeof( property_base ) + StringMemory();
+    }
+
     /** Set index of category holding this property */
     void category_index( int i )
     {
@@ -106,8 +182,27 @@ public:
 protected:
     eType myType;
     int myCatIndex;
+
+    /** Heap memory used by name and label */
+    size_t StringMemory() const
+    {
+        return HeapMemory( myName ) + HeapMemory( myLabel );
+    }
 };
 
+/** vector of pointers to properties */
+typedef std::shared_ptr< property_base > prop_t;
+typedef std::vector< prop_t > vector_t;
+
+/** Heap memory used by a vector of properties, including the properties */
+inline size_t HeapMemory( const vector_t& v )
+{
+    size_t bytes = v.capacity() * sizeof( prop_t );
+    for( auto& p : v )
+        bytes += theControlBlockMemory + p->Memory();
+    return bytes;
+}
+
 /** Property that takes a string values */
 
 class text :  public property_base
@@ -150,6 +245,11 @@ public:
     */
     std::string Edit( nana::window wd );
 
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory() + HeapMemory( myValue );
+    }
+
 private:
     std::string myValue;
 };
@@ -160,7 +260,7 @@ class integer :  public property_base
 {
 public:
     integer( const std::string& name, int v )
-        : property_base( name, name, eType::Str )
+        : property_base( name, name, eType::Int )
     {
         myValue = v;
     }
@@ -168,7 +268,7 @@ public:
         const std::string& name,
         const std::string& label,
         int v )
-        : property_base( name, label, eType::Str )
+        : property_base( name, label, eType::Int )
     {
         myValue = v;
     }
@@ -186,8 +286,41 @@ public:
     {
         myValue = v;
     }
+    bool TrySetValue( const std::string& sv )
+    {
+        char * end;
+        errno = 0;
+        long v = strtol( sv.c_str(), &end, 10 );
+        if( end == sv.c_str() || *end )
+            return false;
+        if( errno == ERANGE || v < INT_MIN || v > INT_MAX )
+            return false;
+        myValue = v;
+        return true;
+    }
+    int Value() const
+    {
+        return myValue;
+    }
+    bool ValueAsNumber( double& v ) const
+    {
+        v = myValue;
+        return true;
+    }
+    bool SetNumber( double v )
+    {
+        if( v < INT_MIN || v > INT_MAX )
+            return false;
+        myValue = v;
+        return true;
+    }
     std::string Edit( nana::window wd );
 
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory();
+    }
+
 private:
     int myValue;
 };
@@ -198,7 +331,7 @@ class real :  public property_base
 {
 public:
     real( const std::string& name, double v )
-        : property_base( name, name, eType::Str )
+        : property_base( name, name, eType::Dbl )
     {
         myValue = v;
     }
@@ -206,7 +339,7 @@ public:
         const std::string& name,
         const std::string& label,
         double v )
-        : property_base( name, label, eType::Str )
+        : property_base( name, label, eType::Dbl )
     {
         myValue = v;
     }
@@ -224,23 +357,169 @@ public:
     {
         myValue = v;
     }
+    bool TrySetValue( const std::string& sv )
+    {
+        char * end;
+        double v = strtod( sv.c_str(), &end );
+        if( end == sv.c_str() || *end )
+            return false;
+        myValue = v;
+        return true;
+    }
+    double Value() const
+    {
+        return myValue;
+    }
+    bool ValueAsNumber( double& v ) const
+    {
+        v = myValue;
+        return true;
+    }
+    bool SetNumber( double v )
+    {
+        myValue = v;
+        return true;
+    }
     std::string Edit( nana::window wd );
 
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory();
+    }
+
 private:
     double myValue;
 };
 
 /** Separator marking start of new category or group which can be collapsed.
+
+A category constructed with a provider is lazy.
+Its properties are not stored in the external vector,
+instead the provider is called to create them
+the first time the category is expanded in the grid.
 */
 class category : public property_base
 {
 public:
+
+    /** Function that appends the properties of a lazy category to a vector */
+    typedef std::function< void( vector_t& ) > provider_t;
+
+    /** Function that stores edited properties of a lazy category before they are released */
+    typedef std::function< void( const vector_t& ) > saver_t;
+
     /** CTOR
     @param[in] name of category
     */
     category( const std::string& name )
         : property_base( name, name, eType::Cat )
+        , myfAsync( false )
+        , myfLoaded( false )
+        , myfEdited( false )
+    {
+    }
+
+    /** CTOR for lazy category
+    @param[in] name of category
+    @param[in] provider function to create the properties in the category
+    @param[in] fAsync true if provider should be called on a worker thread
+    @param[in] saver function to store edited properties before they are released
+
+    When fAsync is true the provider must not touch the GUI.
+
+    Without a saver, properties edited by the user are never released,
+    so their values are not replaced by the provider's.
+    */
+    category(
+        const std::string& name,
+        provider_t provider,
+        bool fAsync = false,
+        saver_t saver = saver_t() )
+        : property_base( name, name, eType::Cat )
+        , myProvider( provider )
+        , mySaver( saver )
+        , myfAsync( fAsync )
+        , myfLoaded( false )
+        , myfEdited( false )
+    {
+    }
+
+    /** true if category properties are created by a provider */
+    bool IsLazy() const
+    {
+        return (bool) myProvider;
+    }
+
+    /** true if provider should be called on a worker thread */
+    bool IsAsync() const
     {
+        return myfAsync;
+    }
+
+    /** true if provider has been called and properties not released */
+    bool IsLoaded() const
+    {
+        return myfLoaded;
+    }
+
+    /** Get the provider */
+    provider_t Provider() const
+    {
+        return myProvider;
+    }
+
+    /** Call provider, if not already loaded
+        @return the properties in the category
+    */
+    vector_t& Load()
+    {
+        if( ! myfLoaded && IsLazy() )
+        {
+            myProvider( myChildren );
+            myfLoaded = true;
+        }
+        return myChildren;
+    }
+
+    /** Store properties created by a provider on a worker thread
+        @param[in] v the properties, moved into the category
+    */
+    void Loaded( vector_t&& v )
+    {
+        myChildren = std::move( v );
+        myfLoaded = true;
+    }
+
+    /** Note that a property created by provider has been edited */
+    void Edited()
+    {
+        myfEdited = true;
+    }
+
+    /** true if the properties created by provider can be released without losing edits */
+    bool IsReleasable() const
+    {
+        return myfLoaded && ( ! myfEdited || mySaver );
+    }
+
+    /** Free the properties created by provider
+
+    Edited properties are passed to the saver first.
+    They will be created again by the next call to Load()
+    */
+    void Release()
+    {
+        if( myfEdited && mySaver )
+            mySaver( myChildren );
+        vector_t().swap( myChildren );
+        myfLoaded = false;
+        myfEdited = false;
+    }
+
+    /** Get the properties created by provider */
+    vector_t& Children()
+    {
+        return myChildren;
     }
     std::string ValueAsString() const
     {
@@ -250,6 +529,10 @@ public:
     /** Categories do not have values, NOP function to satisfy compiler */
     void SetValue( const std::string& sv )
     {}
+    bool TrySetValue( const std::string& sv )
+    {
+        return false;
+    }
 
     /** Categories cannot be edited, NOP function to satisfy compiler */
     std::string Edit( nana::window wd )
@@ -257,6 +540,19 @@ public:
         return "";
     }
 
+    /** Memory used, including properties created by provider */
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory() + HeapMemory( myChildren );
+    }
+
+private:
+    provider_t myProvider;
+    saver_t mySaver;
+    vector_t myChildren;
+    bool myfAsync;
+    bool myfLoaded;
+    bool myfEdited;     ///< true if a child has been edited since loaded
 };
 
 /** Property that can be true or false */
@@ -290,13 +586,429 @@ public:
         else
             myValue = false;
     }
+    bool TrySetValue( const std::string& sv )
+    {
+        if( sv != "true" && sv != "false" )
+            return false;
+        myValue = ( sv == "true" );
+        return true;
+    }
 
     std::string Edit( nana::window wd );
 
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory();
+    }
+
 private:
     bool myValue;
 };
 
+/** Property whose value is calculated by a getter function
+
+The value is cached after the getter is called
+and the getter is not called again until the value is invalidated.
+The grid only calls the getter when the property is in an expanded category,
+showing a placeholder until the value is available.
+*/
+
+class computed : public property_base
+{
+public:
+
+    /** Function that calculates the value */
+    typedef std::function< std::string() > getter_t;
+
+    /** CTOR
+        @param[in] name unique name for property
+        @param[in] getter function to calculate value
+        @param[in] fAsync true if grid should call getter on a worker thread
+
+        When fAsync is true the getter must not touch the GUI.
+    */
+    computed(
+        const std::string& name,
+        getter_t getter,
+        bool fAsync = false )
+        : computed( name, name, getter, fAsync )
+    {
+
+    }
+    computed(
+        const std::string& name,
+        const std::string& label,
+        getter_t getter,
+        bool fAsync = false )
+        : property_base( name, label, eType::Str )
+        , myGetter( getter )
+        , myfAsync( fAsync )
+        , myfValid( false )
+        , myGeneration( 0 )
+    {
+
+    }
+
+    /** Get value, calling getter if cached value is invalid */
+    std::string ValueAsString() const
+    {
+        if( ! myfValid )
+        {
+            myValue = myGetter();
+            myfValid = true;
+        }
+        return myValue;
+    }
+
+    /** Computed values cannot be set, NOP function to satisfy compiler */
+    void SetValue( const std::string& sv )
+    {}
+    bool TrySetValue( const std::string& sv )
+    {
+        return false;
+    }
+
+    /** Computed values cannot be edited, the current value is returned */
+    std::string Edit( nana::window wd )
+    {
+        return ValueAsString();
+    }
+
+    /** Discard cached value, so getter will be called when value next needed */
+    void Invalidate()
+    {
+        myfValid = false;
+        myGeneration++;
+    }
+
+    /** Count of invalidations, read when a getter starts on a worker thread */
+    unsigned Generation() const
+    {
+        return myGeneration;
+    }
+
+    /** true if cached value is valid */
+    bool IsValid() const
+    {
+        return myfValid;
+    }
+
+    /** true if grid should call getter on a worker thread */
+    bool IsAsync() const
+    {
+        return myfAsync;
+    }
+
+    /** Get the getter */
+    getter_t Getter() const
+    {
+        return myGetter;
+    }
+
+    /** Memory used, not including any heap allocated by the getter */
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory() + HeapMemory( myValue );
+    }
+
+    /** Store value calculated on a worker thread
+        @param[in] v value returned by getter
+        @param[in] generation Generation() when the getter started
+        @return false if invalidated since the getter started, value discarded
+    */
+    bool Cache( const std::string& v, unsigned generation )
+    {
+        if( generation != myGeneration )
+            return false;
+        myValue = v;
+        myfValid = true;
+        return true;
+    }
+
+private:
+    getter_t myGetter;
+    mutable std::string myValue;
+    bool myfAsync;
+    mutable bool myfValid;
+    unsigned myGeneration;
+};
+
+/** Base class for properties holding an array of values
+
+The grid displays a summary row, which the user clicks to show the elements.
+Element rows are created a page at a time, as the user asks for them.
+*/
+
+class array_base : public property_base
+{
+public:
+    array_base(
+        const std::string& name,
+        const std::string& label )
+        : property_base( name, label, eType::Arr )
+    {
+
+    }
+
+    /** Number of elements */
+    virtual size_t size() const = 0;
+
+    /** Type of elements */
+    virtual eType ElementType() const = 0;
+
+    /** Get element value as a string, "" if i is past the end */
+    virtual std::string ElementAsString( size_t i ) const = 0;
+
+    /** Get element value as a number, 0 if i is past the end */
+    virtual double ElementAsNumber( size_t i ) const = 0;
+
+    /** Set element value from a string
+        @return false if sv is not a valid value or i is past the end
+    */
+    virtual bool SetElement( size_t i, const std::string& sv ) = 0;
+
+    /** Copy size and elements of another array
+        @return false if the elements cannot be held by this array
+    */
+    virtual bool Assign( const array_base& other ) = 0;
+
+    /** Arrays are edited element by element, the current value is returned */
+    std::string Edit( nana::window wd )
+    {
+        return ValueAsString();
+    }
+};
+
+/** Property holding an array of numbers, stored contiguously
+
+    @param T type of element, int or double
+*/
+
+template < class T >
+class array : public array_base
+{
+public:
+    array(
+        const std::string& name,
+        const std::vector< T >& v )
+        : array( name, name, v )
+    {
+
+    }
+    array(
+        const std::string& name,
+        const std::string& label,
+        const std::vector< T >& v )
+        : array_base( name, label )
+        , myValue( v )
+        , myfRange( false )
+    {
+
+    }
+
+    /** Get summary of value: size, minimum and maximum */
+    std::string ValueAsString() const
+    {
+        std::stringstream ss;
+        ss << "[" << myValue.size() << "]";
+        if( myValue.size() )
+        {
+            Range();
+            ss << " " << myMin << " .. " << myMax;
+        }
+        return ss.str();
+    }
+
+    /** Set value from a list of numbers, separated by spaces or commas */
+    void SetValue( const std::string& sv )
+    {
+        TrySetValue( sv );
+    }
+    bool TrySetValue( const std::string& sv )
+    {
+        std::string list( sv );
+        std::replace( list.begin(), list.end(), ',', ' ' );
+        std::stringstream ss( list );
+        std::vector< T > v;
+        T e;
+        while( ss >> e )
+            v.push_back( e );
+        if( ! ss.eof() )
+            return false;
+        myValue.swap( v );
+        myfRange = false;
+        return true;
+    }
+
+    /** Set all elements
+        @param[in] p pointer to first of n values
+        @param[in] n number of values
+    */
+    void Set( const T * p, size_t n )
+    {
+        myValue.assign( p, p + n );
+        myfRange = false;
+    }
+
+    /** Copy elements
+        @param[out] p pointer to buffer for n values
+        @param[in] n number of values to copy, from the first
+        @return number of values copied
+    */
+    size_t Get( T * p, size_t n ) const
+    {
+        n = std::min( n, myValue.size() );
+        std::copy( myValue.begin(), myValue.begin() + n, p );
+        return n;
+    }
+
+    /** Pointer to contiguous elements */
+    const T * data() const
+    {
+        return myValue.data();
+    }
+
+    size_t size() const
+    {
+        return myValue.size();
+    }
+
+    eType ElementType() const
+    {
+        return std::is_integral< T >::value ? eType::Int : eType::Dbl;
+    }
+
+    std::string ElementAsString( size_t i ) const
+    {
+        if( i >= myValue.size() )
+            return "";
+        std::stringstream ss;
+        ss << myValue[ i ];
+        return ss.str();
+    }
+
+    double ElementAsNumber( size_t i ) const
+    {
+        if( i >= myValue.size() )
+            return 0;
+        return myValue[ i ];
+    }
+
+    bool SetElement( size_t i, const std::string& sv )
+    {
+        if( i >= myValue.size() )
+            return false;
+        std::stringstream ss( sv );
+        T e;
+        if( ! ( ss >> e ) || ! ( ss >> std::ws ).eof() )
+            return false;
+        myValue[ i ] = e;
+        myfRange = false;
+        return true;
+    }
+
+    bool Assign( const array_base& other )
+    {
+        if( std::is_integral< T >::value && other.ElementType() != eType::Int )
+            return false;
+        std::vector< T > v( other.size() );
+        for( size_t i = 0; i < v.size(); i++ )
+            v[ i ] = (T)other.ElementAsNumber( i );
+        myValue.swap( v );
+        myfRange = false;
+        return true;
+    }
+
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory() + myValue.capacity() * sizeof( T );
+    }
+
+private:
+    std::vector< T > myValue;
+    mutable bool myfRange;      ///< true if myMin and myMax are up to date
+    mutable T myMin;
+    mutable T myMax;
+
+    void Range() const
+    {
+        if( myfRange )
+            return;
+        auto mm = std::minmax_element( myValue.begin(), myValue.end() );
+        myMin = *mm.first;
+        myMax = *mm.second;
+        myfRange = true;
+    }
+};
+
+/** Property displaying one element of an array
+
+The grid creates these as the user expands an array.
+If the array is destroyed the element has no value and cannot be set.
+*/
+
+class element : public property_base
+{
+public:
+    element(
+        const std::shared_ptr< array_base >& a,
+        size_t i )
+        : property_base(
+              a->myName + Subscript( i ),
+              "  " + Subscript( i ),
+              a->ElementType() )
+        , myArray( a )
+        , myIndex( i )
+    {
+
+    }
+    std::string ValueAsString() const
+    {
+        auto a = myArray.lock();
+        return a ? a->ElementAsString( myIndex ) : "";
+    }
+    void SetValue( const std::string& sv )
+    {
+        TrySetValue( sv );
+    }
+    bool TrySetValue( const std::string& sv )
+    {
+        auto a = myArray.lock();
+        return a && a->SetElement( myIndex, sv );
+    }
+    bool ValueAsNumber( double& v ) const
+    {
+        auto a = myArray.lock();
+        if( ! a )
+            return false;
+        v = a->ElementAsNumber( myIndex );
+        return true;
+    }
+    std::string Edit( nana::window wd );
+
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory();
+    }
+
+    /** Get the array holding the element, empty if it has been destroyed */
+    std::shared_ptr< array_base > Array() const
+    {
+        return myArray.lock();
+    }
+
+private:
+    std::weak_ptr< array_base > myArray;
+    size_t myIndex;
+
+    static std::string Subscript( size_t i )
+    {
+        std::stringstream ss;
+        ss << "[" << i << "]";
+        return ss.str();
+    }
+};
+
 /** Property that can take on one of a defined set of string values */
 
 class options : public property_base
@@ -348,20 +1060,170 @@ public:
         else
             mySelection = it - myValue.begin();
     }
+    bool TrySetValue( const std::string& sv )
+    {
+        auto it = std::find(
+                      myValue.begin(),
+                      myValue.end(),
+                      sv );
+        if( it == myValue.end() )
+            return false;
+        mySelection = it - myValue.begin();
+        return true;
+    }
 
     std::string Edit( nana::window wd );
 
+    size_t Memory() const
+    {
+        size_t bytes = sizeof( *this ) + StringMemory()
+                       + myValue.capacity() * sizeof( std::string );
+        for( auto& o : myValue )
+            bytes += HeapMemory( o );
+        return bytes;
+    }
+
 private:
     std::vector< std::string > myValue;
     int mySelection;
 };
 
-typedef std::shared_ptr< property_base > prop_t;
+/** Stable reference to a property
+
+Unlike a position in a property vector,
+a handle is unaffected by insertions and removals in the vector.
+*/
+struct handle
+{
+    unsigned index;         ///< slot in the handle table
+    unsigned generation;    ///< generation of slot when handle was issued
+};
+
+/** Table of handles to properties
+
+Get(), Add() and Remove() are O(1).
+Slots of removed properties are reused,
+the generation count of the slot distinguishes the new property
+from stale handles to the removed one.
+The table does not own the properties,
+a handle to a property that has been destroyed is stale.
+*/
+class handle_table
+{
+public:
+
+    /** Issue handle to property */
+    handle Add( const prop_t& p )
+    {
+        handle h;
+        if( myFree.size() )
+        {
+            h.index = myFree.back();
+            myFree.pop_back();
+        }
+        else
+        {
+            h.index = mySlots.size();
+            mySlots.push_back( slot() );
+        }
+        mySlots[ h.index ].prop = p;
+        mySlots[ h.index ].address = p.get();
+        h.generation = mySlots[ h.index ].generation;
+        return h;
+    }
+
+    /** Make handle, and any copies of it, stale */
+    void Remove( handle h )
+    {
+        if( ! IsValid( h ) )
+            return;
+        slot& s = mySlots[ h.index ];
+        s.prop.reset();
+        s.address = 0;
+        s.generation++;
+        myFree.push_back( h.index );
+    }
+
+    /** Get property
+        @param[in] h handle to property
+        @return pointer to property, empty if handle is stale
+    */
+    prop_t Get( handle h ) const
+    {
+        if( ! IsValid( h ) )
+            return prop_t();
+        return mySlots[ h.index ].prop.lock();
+    }
+
+    /** Get address of property the handle was issued for
+        @param[in] h handle to property
+        @return address, even if the property has been destroyed, 0 if handle is stale
+
+        Use this to remove the property from tables keyed by address,
+        do not dereference it.
+    */
+    property_base * Address( handle h ) const
+    {
+        if( ! IsValid( h ) )
+            return 0;
+        return mySlots[ h.index ].address;
+    }
+
+    /** true if handle was issued by this table and has not been removed */
+    bool IsValid( handle h ) const
+    {
+        return h.index < mySlots.size()
+               && mySlots[ h.index ].generation == h.generation;
+    }
+
+    /** Get memory used by table, in bytes */
+    size_t Memory() const
+    {
+        return sizeof( *this )
+               + mySlots.capacity() * sizeof( slot )
+               + myFree.capacity() * sizeof( unsigned );
+    }
+
+    /** Make all handles stale */
+    void clear()
+    {
+        myFree.clear();
+        for( unsigned k = 0; k < mySlots.size(); k++ )
+        {
+            Remove( handle { k, mySlots[ k ].generation } );
+        }
+    }
+
+private:
+    struct slot
+    {
+        std::weak_ptr< property_base > prop;
+        property_base * address = 0;
+        unsigned generation = 0;
+    };
+    std::vector< slot > mySlots;
+    std::vector< unsigned > myFree;     ///< slots available for reuse
+};
+
+/** Memory used by properties, in bytes */
+struct memory_t
+{
+    size_t total;
+    std::map< eType, size_t > type;             ///< by property type
+    std::map< std::string, size_t > category;   ///< by category name, "" for properties before the first category
+};
 
 class property_container
 {
 public:
 
+    /** Entry that could not be applied by Apply() */
+    struct apply_error
+    {
+        int index;                  ///< zero-based position of entry
+        std::string message;
+    };
+
     void Add(
         const std::string& name,
         const std::string& label,
@@ -406,6 +1268,40 @@ public:
     {
         myProperties.emplace_back( prop_t ( new prop::category( name )));
     }
+
+    /** Add lazy category
+        @param[in] name of category
+        @param[in] provider function to create the properties in the category
+        @param[in] fAsync true if provider should be called on a worker thread
+        @param[in] saver function to store edited properties before they are released
+
+        The provider's properties are not in the container,
+        so find(), Apply() and Save() do not see them.
+        Pass a saver to keep their edited values when a grid releases them.
+    */
+    void AddLazy(
+        const std::string& name,
+        category::provider_t provider,
+        bool fAsync = false,
+        category::saver_t saver = category::saver_t() )
+    {
+        myProperties.emplace_back( prop_t ( new prop::category( name, provider, fAsync, saver )));
+    }
+    template < class T >
+    void AddArray(
+        const std::string& name,
+        const std::string& label,
+        const std::vector< T >& value )
+    {
+        myProperties.emplace_back( prop_t ( new prop::array< T >( name, label, value )));
+    }
+    template < class T >
+    void AddArray(
+        const std::string& name,
+        const std::vector< T >& value )
+    {
+        AddArray( name, name, value );
+    }
     void AddBool(
         const std::string& name,
         const std::string& label,
@@ -417,7 +1313,7 @@ public:
         const std::string& name,
         bool value )
     {
-        Add( name, name, value );
+        AddBool( name, name, value );
     }
     void Add(
         const std::string& name,
@@ -433,6 +1329,294 @@ public:
         Add( name, name, value );
     }
 
+    void AddComputed(
+        const std::string& name,
+        const std::string& label,
+        computed::getter_t getter,
+        bool fAsync = false )
+    {
+        myProperties.emplace_back( prop_t ( new computed( name, label, getter, fAsync )));
+    }
+    void AddComputed(
+        const std::string& name,
+        computed::getter_t getter,
+        bool fAsync = false )
+    {
+        AddComputed( name, name, getter, fAsync );
+    }
+
+    /** Add derived property, calculated from other properties
+        @param[in] name unique name for property
+        @param[in] label to display
+        @param[in] getter function to calculate value from the inputs
+        @param[in] inputs names of properties used by getter
+
+        The inputs must already have been added,
+        so the dependencies can never form a cycle.
+        When an input changes through SetValue() or the grid editor
+        the property is recalculated, along with everything downstream of it.
+    */
+    void AddDerived(
+        const std::string& name,
+        const std::string& label,
+        computed::getter_t getter,
+        const std::vector< std::string >& inputs )
+    {
+        for( auto& in : inputs )
+        {
+            if( ! find( in ) )
+            {
+                std::stringstream ss;
+                ss << "property_container.AddDerived() " << name
+                   << " input not found: " << in;
+                throw std::runtime_error( ss.str() );
+            }
+        }
+        std::shared_ptr< computed > derived( new computed( name, label, getter ));
+        myProperties.emplace_back( derived );
+
+        // derived properties are stored in the order added,
+        // which is a topological order of the dependency graph
+        int index = myDerived.size();
+        myDerived.push_back( derived );
+        for( auto& in : inputs )
+            myDependents[ in ].push_back( index );
+    }
+    void AddDerived(
+        const std::string& name,
+        computed::getter_t getter,
+        const std::vector< std::string >& inputs )
+    {
+        AddDerived( name, name, getter, inputs );
+    }
+
+    /** Find position of property
+        @param[in] name of property
+        @return position in the vector returned by get(), -1 if not found
+    */
+    int Slot( const std::string& name )
+    {
+        Index();
+        auto it = myIndex.find( name );
+        if( it == myIndex.end() )
+            return -1;
+        return it->second;
+    }
+
+    /** Find property
+        @param[in] name of property
+        @return pointer to property, empty if not found
+    */
+    prop_t find( const std::string& name )
+    {
+        Index();
+        auto it = myIndex.find( name );
+        if( it == myIndex.end() )
+            return prop_t();
+        return myProperties[ it->second ];
+    }
+
+    /** Get memory used by container
+        @return bytes used by the properties, by type, by category and in total
+
+        A property's bytes include its shared_ptr control block and heap allocations.
+        The total also includes the container's own vectors and hash tables.
+        Heap allocations are rounded by the allocator, so this is a lower bound.
+    */
+    memory_t Memory() const
+    {
+        memory_t m;
+        m.total = sizeof( *this ) + myProperties.capacity() * sizeof( prop_t );
+        std::string cat;
+        m.category[ cat ] = 0;
+        for( auto& p : myProperties )
+        {
+            if( p->Type() == eType::Cat )
+                cat = p->myName;
+            size_t bytes = theControlBlockMemory + p->Memory();
+            m.category[ cat ] += bytes;
+            m.total += bytes;
+
+            // properties created by a lazy category's provider are counted by their own types
+            auto c = std::dynamic_pointer_cast< category >( p );
+            if( c )
+            {
+                for( auto& child : c->Children() )
+                {
+                    size_t childBytes = theControlBlockMemory + child->Memory();
+                    m.type[ child->Type() ] += childBytes;
+                    bytes -= childBytes;
+                }
+            }
+            m.type[ p->Type() ] += bytes;
+        }
+
+        // derived property bookkeeping
+        m.total += myDerived.capacity() * sizeof( std::shared_ptr< computed > );
+        m.total += myDependents.bucket_count() * sizeof( void* );
+        for( auto& d : myDependents )
+            m.total += sizeof( void* ) + sizeof( d ) + HeapMemory( d.first )
+                       + d.second.capacity() * sizeof( int );
+
+        // name index
+        m.total += myIndex.bucket_count() * sizeof( void* );
+        for( auto& i : myIndex )
+            m.total += sizeof( void* ) + sizeof( i ) + HeapMemory( i.first );
+
+        return m;
+    }
+
+    /** Bring name index up to date with properties added since last use
+
+    find() does this itself,
+    call it first if find() will be called from several threads at once.
+    */
+    void Index()
+    {
+        for( ; myIndexed < (int)myProperties.size(); myIndexed++ )
+            myIndex.insert( std::make_pair( myProperties[ myIndexed ]->myName, myIndexed ));
+    }
+
+    /** Discard the name index
+
+    Call after inserting or removing properties in the vector returned by get()
+    */
+    void Reindex()
+    {
+        myIndex.clear();
+        myIndexed = 0;
+    }
+
+    /** Set property value from a string
+        @param[in] name of property
+        @param[in] sv value as string
+        @return false if property not found
+
+        Derived properties downstream of the property are recalculated.
+    */
+    bool SetValue(
+        const std::string& name,
+        const std::string& sv )
+    {
+        prop_t p = find( name );
+        if( ! p )
+            return false;
+        p->SetValue( sv );
+        Changed( p );
+        return true;
+    }
+
+    /** Set many property values from strings
+        @param[in] first iterator to first ( name, value ) pair
+        @param[in] last iterator past last pair
+        @return entries that could not be applied
+
+        Entries with unknown names or invalid values are skipped and reported.
+        The derived properties downstream of all the changed properties
+        are recalculated once, then the listener is notified once.
+    */
+    template < class It >
+    std::vector< apply_error > Apply( It first, It last )
+    {
+        std::vector< apply_error > errors;
+        vector_t changed;
+        Index();
+        int index = 0;
+        for( ; first != last; first++, index++ )
+        {
+            auto it = myIndex.find( first->first );
+            if( it == myIndex.end() )
+            {
+                errors.push_back( { index, "property not found: " + first->first } );
+                continue;
+            }
+            prop_t& p = myProperties[ it->second ];
+            if( ! p->TrySetValue( first->second ) )
+            {
+                errors.push_back( { index, "invalid value for " + first->first + ": " + first->second } );
+                continue;
+            }
+            changed.push_back( p );
+        }
+        Changed( changed );
+        return errors;
+    }
+    std::vector< apply_error > Apply(
+        const std::vector< std::pair< std::string, std::string > >& patch )
+    {
+        return Apply( patch.begin(), patch.end() );
+    }
+
+    /** Property value has changed
+        @param[in] p the changed property
+    */
+    void Changed( const prop_t& p )
+    {
+        Changed( vector_t { p } );
+    }
+
+    /** Property values have changed
+        @param[in] inputs the changed properties
+
+        Recalculates the derived properties downstream of the inputs in topological order
+        then notifies the listener of the inputs and the recalculated properties.
+    */
+    void Changed( const vector_t& inputs )
+    {
+        if( ! inputs.size() )
+            return;
+        vector_t changed( inputs );
+        std::vector< int > stack;
+        for( auto& p : inputs )
+        {
+            auto it = myDependents.find( p->myName );
+            if( it != myDependents.end() )
+                stack.insert( stack.end(), it->second.begin(), it->second.end() );
+        }
+        if( stack.size() )
+        {
+            // find everything downstream
+            std::vector< bool > visited( myDerived.size(), false );
+            std::vector< int > affected;
+            while( stack.size() )
+            {
+                int d = stack.back();
+                stack.pop_back();
+                if( visited[ d ] )
+                    continue;
+                visited[ d ] = true;
+                affected.push_back( d );
+                auto next = myDependents.find( myDerived[ d ]->myName );
+                if( next != myDependents.end() )
+                    stack.insert( stack.end(), next->second.begin(), next->second.end() );
+            }
+
+            // recalculate in topological order
+            std::sort( affected.begin(), affected.end() );
+            for( int d : affected )
+                myDerived[ d ]->Invalidate();
+            for( int d : affected )
+            {
+                myDerived[ d ]->ValueAsString();
+                changed.push_back( myDerived[ d ] );
+            }
+        }
+        if( myListener )
+            myListener( changed );
+    }
+
+    /** Function called with properties whose values have changed */
+    typedef std::function< void( const vector_t& changed ) > listener_t;
+
+    /** Register function to be called when property values change
+
+    There is one listener, a property grid displaying the container registers itself
+    */
+    void Listen( listener_t listener )
+    {
+        myListener = listener;
+    }
+
     std::vector< prop_t >& get()
     {
         return myProperties;
@@ -450,8 +1634,213 @@ public:
 
 private:
     std::vector< prop_t > myProperties;
+
+    /// derived properties, in the order added
+    std::vector< std::shared_ptr< computed > > myDerived;
+
+    /// indices in myDerived of the derived properties using each property, keyed by name
+    std::unordered_map< std::string, std::vector< int > > myDependents;
+
+    listener_t myListener;
+
+    /// position in myProperties of each property, keyed by name
+    std::unordered_map< std::string, int > myIndex;
+
+    /// count of properties in myIndex
+    int myIndexed = 0;
+};
+
+/** Differences between two property containers, by property name */
+struct diff_t
+{
+    std::vector< std::string > added;       ///< in other, not in base
+    std::vector< std::string > removed;     ///< in base, not in other
+    std::vector< std::string > changed;     ///< in both, with different values
 };
 
+/** true if two properties hold the same value
+
+Numbers are compared as numbers, arrays element by element,
+other values by their text.
+*/
+inline bool SameValue( const property_base& a, const property_base& b )
+{
+    double na, nb;
+    if( a.ValueAsNumber( na ) && b.ValueAsNumber( nb ) )
+        return na == nb;
+    auto aa = dynamic_cast< const array_base* >( &a );
+    auto ab = dynamic_cast< const array_base* >( &b );
+    if( aa && ab )
+    {
+        if( aa->size() != ab->size() )
+            return false;
+        for( size_t i = 0; i < aa->size(); i++ )
+            if( aa->ElementAsNumber( i ) != ab->ElementAsNumber( i ) )
+                return false;
+        return true;
+    }
+    return a.ValueAsString() == b.ValueAsString();
 }
+
+/** Find differences between two property containers
+    @param[in] base container
+    @param[in] other container
+    @param[in] threads number of worker threads to compare with
+    @return names of properties added, removed and changed
+
+    Names are looked up in the containers' hash indices,
+    so this is linear in the number of properties.
+    With more than one thread the properties are split into chunks
+    compared on worker threads.
+    Computed properties whose getters are not async are still compared
+    on the calling thread, after the workers finish.
+*/
+inline diff_t Diff(
+    property_container& base,
+    property_container& other,
+    unsigned threads = 1 )
+{
+    base.Index();
+    other.Index();
+
+    // getters of computed properties that are not async may need the calling thread
+    auto serial = []( property_base& p )
+    {
+        auto comp = dynamic_cast< computed* >( &p );
+        return comp && ! comp->IsAsync();
+    };
+
+    // compare properties in [first,last) of v with those of the same names in c
+    // in both directions: changed and added are found from other, removed from base
+    // properties that must be compared serially are added to deferred, if given
+    auto compare = [serial]( property_container& c, vector_t& v, int first, int last,
+                             diff_t& d, bool fBase, vector_t * deferred )
+    {
+        for( int k = first; k < last; k++ )
+        {
+            prop_t& p = v[ k ];
+            if( p->Type() == eType::Cat )
+                continue;
+            prop_t q = c.find( p->myName );
+            if( ! q )
+            {
+                if( fBase )
+                    d.removed.push_back( p->myName );
+                else
+                    d.added.push_back( p->myName );
+            }
+            else if( fBase )
+                continue;
+            else if( deferred && ( serial( *p ) || serial( *q ) ) )
+                deferred->push_back( p );
+            else if( ! SameValue( *p, *q ) )
+                d.changed.push_back( p->myName );
+        }
+    };
+
+    if( threads < 1 )
+        threads = 1;
+    typedef std::pair< diff_t, vector_t > result_t;
+    std::vector< std::future< result_t > > work;
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        bool fBase = ( pass == 0 );
+        property_container& c = fBase ? other : base;
+        vector_t& v = fBase ? base.get() : other.get();
+        int chunk = ( v.size() + threads - 1 ) / threads;
+        for( int first = 0; first < (int)v.size(); first += chunk )
+        {
+            int last = std::min( first + chunk, (int)v.size() );
+            bool fAsync = threads > 1;
+            work.push_back( std::async(
+                                fAsync ? std::launch::async : std::launch::deferred,
+                                [&c, &v, first, last, fBase, fAsync, compare]
+            {
+                result_t r;
+                compare( c, v, first, last, r.first, fBase, fAsync ? &r.second : 0 );
+                return r;
+            }));
+        }
+    }
+
+    // concatenate chunk results in order
+    diff_t diff;
+    for( auto& w : work )
+    {
+        result_t r = w.get();
+        diff_t& d = r.first;
+        for( auto& p : r.second )
+            if( ! SameValue( *p, *base.find( p->myName ) ) )
+                d.changed.push_back( p->myName );
+        diff.added.insert( diff.added.end(), d.added.begin(), d.added.end() );
+        diff.removed.insert( diff.removed.end(), d.removed.begin(), d.removed.end() );
+        diff.changed.insert( diff.changed.end(), d.changed.begin(), d.changed.end() );
+    }
+    return diff;
 }
 
+/** Copy value of one property to another of the same type
+    @return false if the value cannot be held by the destination
+
+Numbers and arrays are copied without formatting, other values as text.
+*/
+inline bool CopyValue( property_base& to, const property_base& from )
+{
+    double v;
+    if( from.ValueAsNumber( v ) )
+        return to.SetNumber( v );
+    auto af = dynamic_cast< const array_base* >( &from );
+    if( af )
+    {
+        auto at = dynamic_cast< array_base* >( &to );
+        return at && at->Assign( *af );
+    }
+    return to.TrySetValue( from.ValueAsString() );
+}
+
+/** Three way merge of property values
+    @param[in] base common ancestor of mine and theirs
+    @param[in,out] mine container to merge changes into
+    @param[in] theirs container with changes to merge
+    @return names of properties changed differently in mine and theirs,
+            and of properties whose value in theirs could not be set in mine
+
+    Values changed in theirs, relative to base, are applied to mine
+    unless mine has also changed them to a different value.
+    Conflicting properties keep the value in mine.
+    Only values are merged, properties added or removed in theirs are ignored.
+*/
+inline std::vector< std::string > Merge(
+    property_container& base,
+    property_container& mine,
+    property_container& theirs )
+{
+    std::vector< std::string > conflicts;
+    vector_t changed;
+    diff_t d = Diff( base, theirs );
+    for( auto& name : d.changed )
+    {
+        prop_t m = mine.find( name );
+        if( ! m )
+            continue;
+        prop_t t = theirs.find( name );
+        if( SameValue( *m, *t ) )
+            continue;
+        if( ! SameValue( *m, *base.find( name ) ) )
+        {
+            conflicts.push_back( name );
+            continue;
+        }
+        if( ! CopyValue( *m, *t ) )
+        {
+            conflicts.push_back( name );
+            continue;
+        }
+        changed.push_back( m );
+    }
+    mine.Changed( changed );
+    return conflicts;
+}
+
+}
+}
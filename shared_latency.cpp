@@ -0,0 +1,127 @@
+/** Measure latency from a write into a shared_store to a viewer seeing it
+
+A writer process is forked, which writes the current time into a slot
+at regular intervals.
+The parent polls the slot's sequence counter, as a grid displaying a
+shared_value does, and on each change reads the time written
+to find how long the value took to be seen.
+
+Usage: shared_latency [ writes [ poll interval in microseconds ] ]
+
+A poll interval of 0, the default, spins.
+Use the grid's PollInterval() to see the latency the user will see.
+
+This does not need nana, build on Linux with
+<pre>
+g++ -std=c++11 -O2 -I. shared_latency.cpp -o shared_latency -lrt -pthread
+</pre>
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "shared_store.hpp"
+
+using namespace nana::prop;
+
+/// nanoseconds on the monotonic clock, which is shared by all processes
+static int64_t Now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    int writes = argc > 1 ? atoi( argv[ 1 ] ) : 1000;
+    int poll_us = argc > 2 ? atoi( argv[ 2 ] ) : 0;
+    if( writes < 1 )
+        writes = 1;
+
+    const char * segment = "nanagrid_shared_latency";
+    shared_store store(
+        segment,
+    {
+        { "stamp", shared_store::eSlot::Int },
+        { "count", shared_store::eSlot::Int },
+    } );
+    int stamp = store.Find( "stamp" );
+    int count = store.Find( "count" );
+
+    pid_t writer = fork();
+    if( writer < 0 )
+    {
+        perror( "fork" );
+        return 1;
+    }
+    if( writer == 0 )
+    {
+        // writer process, opens the segment as another process would
+        shared_store w( segment );
+        int ws = w.Find( "stamp" );
+        int wc = w.Find( "count" );
+        for( int k = 1; k <= writes; k++ )
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( 500 ));
+            w.SetInt( ws, Now() );
+            w.SetInt( wc, k );
+        }
+        _exit( 0 );
+    }
+
+    // viewer, polls for updates as shared_value::Updated() does
+    std::vector< int64_t > latency;
+    latency.reserve( writes );
+    uint32_t last = store.Sequence( stamp );
+    bool fExited = false;
+    int status;
+    for( unsigned spin = 0; store.GetInt( count ) < writes; spin++ )
+    {
+        uint32_t seq = store.Sequence( stamp );
+        if( seq != last )
+        {
+            last = seq;
+            latency.push_back( Now() - store.GetInt( stamp ));
+        }
+        if( poll_us )
+            std::this_thread::sleep_for( std::chrono::microseconds( poll_us ));
+
+        // stop if the writer has died, checked occasionally while spinning
+        if( ( poll_us || spin % 4096 == 0 )
+                && waitpid( writer, &status, WNOHANG ) == writer )
+        {
+            fExited = true;
+            break;
+        }
+    }
+    if( ! fExited )
+        waitpid( writer, &status, 0 );
+    if( store.GetInt( count ) < writes )
+    {
+        printf( "writer exited after %d of %d writes\n",
+                (int)store.GetInt( count ), writes );
+        return 1;
+    }
+
+    if( ! latency.size() )
+    {
+        printf( "no updates seen\n" );
+        return 1;
+    }
+    std::sort( latency.begin(), latency.end() );
+    int64_t total = 0;
+    for( auto l : latency )
+        total += l;
+    printf( "%d writes, %d seen, poll interval %d us\n",
+            writes, (int)latency.size(), poll_us );
+    printf( "latency us: min %.1f median %.1f average %.1f max %.1f\n",
+            latency.front() / 1000.,
+            latency[ latency.size() / 2 ] / 1000.,
+            total / 1000. / latency.size(),
+            latency.back() / 1000. );
+    return 0;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include "grid.hpp"
+#include "shared_store.hpp"
+
+namespace nana
+{
+namespace prop
+{
+
+/** Property displaying a value in a shared memory store
+
+The value is written by another process.
+A grid displaying the property polls the sequence counter of the slot
+and redisplays the value only when it has been written.
+The value cannot be edited in the grid.
+*/
+
+class shared_value : public property_base
+{
+public:
+
+    /** CTOR
+        @param[in] store shared memory store holding value
+        @param[in] slot index of value in store
+        @param[in] label to display
+
+        The name of the property is the name of the value in the store.
+        The store must not be destroyed before the property.
+    */
+    shared_value(
+        shared_store& store,
+        int slot,
+        const std::string& label )
+        : property_base( store.Name( slot ), label, TypeOf( store.Type( slot )))
+        , myStore( store )
+        , mySlot( slot )
+        , mySeq( store.Sequence( slot ) - 1 )
+    {
+
+    }
+    shared_value(
+        shared_store& store,
+        int slot )
+        : shared_value( store, slot, store.Name( slot ))
+    {
+
+    }
+
+    std::string ValueAsString() const
+    {
+        std::stringstream ss;
+        switch( myStore.Type( mySlot ))
+        {
+        case shared_store::eSlot::Int:
+            ss << myStore.GetInt( mySlot );
+            break;
+        case shared_store::eSlot::Dbl:
+            ss << myStore.GetDouble( mySlot );
+            break;
+        case shared_store::eSlot::Bool:
+            return myStore.GetBool( mySlot ) ? "true" : "false";
+        }
+        return ss.str();
+    }
+
+    bool ValueAsNumber( double& v ) const
+    {
+        switch( myStore.Type( mySlot ))
+        {
+        case shared_store::eSlot::Int:
+            v = myStore.GetInt( mySlot );
+            return true;
+        case shared_store::eSlot::Dbl:
+            v = myStore.GetDouble( mySlot );
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** Shared values are written by their producer, NOP function to satisfy compiler */
+    void SetValue( const std::string& sv )
+    {}
+    bool TrySetValue( const std::string& sv )
+    {
+        return false;
+    }
+
+    /** Shared values cannot be edited, the current value is returned */
+    std::string Edit( nana::window wd )
+    {
+        return ValueAsString();
+    }
+
+    size_t Memory() const
+    {
+        return sizeof( *this ) + StringMemory();
+    }
+
+    bool IsLive() const
+    {
+        return true;
+    }
+
+    /** true if the producer has written the value since the last call */
+    bool Updated()
+    {
+        uint32_t seq = myStore.Sequence( mySlot );
+        if( seq == mySeq )
+            return false;
+        mySeq = seq;
+        return true;
+    }
+
+private:
+    shared_store& myStore;
+    int mySlot;
+    uint32_t mySeq;     ///< sequence counter when value last seen
+
+    static eType TypeOf( shared_store::eSlot type )
+    {
+        switch( type )
+        {
+        case shared_store::eSlot::Int:
+            return eType::Int;
+        case shared_store::eSlot::Dbl:
+            return eType::Dbl;
+        default:
+            return eType::Bool;
+        }
+    }
+};
+
+/** Add a property for every value in a shared memory store
+    @param[in] store shared memory store
+    @param[out] v vector of properties to add to
+*/
+inline void AddShared( shared_store& store, vector_t& v )
+{
+    for( int slot = 0; slot < store.size(); slot++ )
+        v.emplace_back( prop_t( new shared_value( store, slot )));
+}
+
+}
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace nana
+{
+namespace prop
+{
+
+/** Property values in a shared memory segment
+
+A producer process creates the store and writes values directly into it.
+A viewer process opens the store and reads the values without copying or parsing strings.
+
+The segment has a fixed layout:
+a header, then one slot per value holding its name, type tag,
+a sequence counter and the value itself.
+The sequence counter is incremented after every write,
+so a viewer can cheaply detect which values have changed.
+
+Values are single 64 bit atomics, so a read never sees a partial write.
+There must be only one writer for each slot.
+
+This header does not depend on nana, so the producer need not link with it.
+*/
+
+class shared_store
+{
+public:
+
+    /** Value types that can be stored */
+    enum class eSlot : uint32_t
+    {
+        Int,        // 64 bit integer
+        Dbl,        // double float
+        Bool,       // boolean
+    };
+
+    /** Definition of a value slot */
+    struct slot_def
+    {
+        std::string name;
+        eSlot type;
+    };
+
+    /** CTOR for producer, creating the segment
+        @param[in] segment name of shared memory segment
+        @param[in] slots names and types of values
+
+        Any existing segment with the same name is replaced.
+        The segment is removed when the producer's store is destroyed.
+    */
+    shared_store(
+        const std::string& segment,
+        const std::vector< slot_def >& slots )
+        : mySegment( segment )
+        , myfOwner( true )
+    {
+        using namespace boost::interprocess;
+
+        // check before creating, the destructor does not run to remove the segment
+        for( auto& s : slots )
+            if( s.name.length() >= sizeof( entry::name ))
+                throw std::runtime_error(
+                    "shared_store name too long: " + s.name );
+
+        shared_memory_object::remove( segment.c_str() );
+        myShm = shared_memory_object( create_only, segment.c_str(), read_write );
+        try
+        {
+            myShm.truncate( sizeof( header ) + slots.size() * sizeof( entry ));
+            myRegion = mapped_region( myShm, read_write );
+        }
+        catch( ... )
+        {
+            shared_memory_object::remove( segment.c_str() );
+            throw;
+        }
+
+        header * h = new ( myRegion.get_address() ) header;
+        h->count = slots.size();
+        myEntry = reinterpret_cast< entry* >( h + 1 );
+        for( int k = 0; k < (int)slots.size(); k++ )
+        {
+            entry * e = new ( myEntry + k ) entry;
+            memcpy( e->name, slots[ k ].name.c_str(), slots[ k ].name.length() + 1 );
+            e->type = slots[ k ].type;
+            e->value = 0;
+            e->seq = 0;
+        }
+
+        // publish the layout, viewers check the magic number
+        h->magic.store( theMagic, std::memory_order_release );
+        Index();
+    }
+
+    /** CTOR for viewer, opening an existing segment
+        @param[in] segment name of shared memory segment
+    */
+    explicit shared_store( const std::string& segment )
+        : mySegment( segment )
+        , myfOwner( false )
+    {
+        using namespace boost::interprocess;
+        myShm = shared_memory_object( open_only, segment.c_str(), read_write );
+        myRegion = mapped_region( myShm, read_write );
+        header * h = static_cast< header* >( myRegion.get_address() );
+        if( myRegion.get_size() < sizeof( header )
+                || h->magic.load( std::memory_order_acquire ) != theMagic )
+            throw std::runtime_error(
+                "shared_store segment not initialized: " + segment );
+        if( ( myRegion.get_size() - sizeof( header )) / sizeof( entry ) < h->count )
+            throw std::runtime_error(
+                "shared_store segment too small for its slots: " + segment );
+        myEntry = reinterpret_cast< entry* >( h + 1 );
+        Index();
+    }
+
+    ~shared_store()
+    {
+        if( myfOwner )
+            boost::interprocess::shared_memory_object::remove( mySegment.c_str() );
+    }
+
+    shared_store( const shared_store& ) = delete;
+    shared_store& operator=( const shared_store& ) = delete;
+
+    /** Number of value slots */
+    int size() const
+    {
+        return myCount;
+    }
+
+    /** Find slot
+        @param[in] name of value
+        @return slot index, -1 if not found
+    */
+    int Find( const std::string& name ) const
+    {
+        auto it = myIndex.find( name );
+        if( it == myIndex.end() )
+            return -1;
+        return it->second;
+    }
+
+    /** Name of value in slot */
+    const char * Name( int slot ) const
+    {
+        return At( slot ).name;
+    }
+
+    /** Type of value in slot */
+    eSlot Type( int slot ) const
+    {
+        return At( slot ).type;
+    }
+
+    /** Sequence counter of slot, incremented by every write */
+    uint32_t Sequence( int slot ) const
+    {
+        return At( slot ).seq.load( std::memory_order_acquire );
+    }
+
+    /** Write value to slot
+
+    The setters and getters throw if the slot does not exist
+    or holds a different type of value.
+    */
+    void SetInt( int slot, int64_t v )
+    {
+        Write( At( slot, eSlot::Int ), static_cast< uint64_t >( v ));
+    }
+    void SetDouble( int slot, double v )
+    {
+        uint64_t bits;
+        memcpy( &bits, &v, sizeof( bits ));
+        Write( At( slot, eSlot::Dbl ), bits );
+    }
+    void SetBool( int slot, bool v )
+    {
+        Write( At( slot, eSlot::Bool ), v ? 1 : 0 );
+    }
+
+    int64_t GetInt( int slot ) const
+    {
+        return static_cast< int64_t >( Read( At( slot, eSlot::Int )));
+    }
+    double GetDouble( int slot ) const
+    {
+        uint64_t bits = Read( At( slot, eSlot::Dbl ));
+        double v;
+        memcpy( &v, &bits, sizeof( v ));
+        return v;
+    }
+    bool GetBool( int slot ) const
+    {
+        return Read( At( slot, eSlot::Bool )) != 0;
+    }
+
+private:
+
+    static const uint32_t theMagic = 0x50524f50;     // "PROP"
+
+    struct header
+    {
+        std::atomic< uint32_t > magic;
+        uint32_t count;
+    };
+
+    struct entry
+    {
+        char name[ 48 ];
+        eSlot type;
+        std::atomic< uint32_t > seq;
+        std::atomic< uint64_t > value;
+    };
+
+    static_assert( ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+                   "shared_store needs lock free atomics to share them between processes" );
+
+    std::string mySegment;
+    bool myfOwner;
+    boost::interprocess::shared_memory_object myShm;
+    boost::interprocess::mapped_region myRegion;
+    entry * myEntry;
+    int myCount;
+
+    /// slot index, keyed by name
+    std::unordered_map< std::string, int > myIndex;
+
+    void Index()
+    {
+        header * h = static_cast< header* >( myRegion.get_address() );
+        myCount = h->count;
+        for( int k = 0; k < myCount; k++ )
+            myIndex.insert( std::make_pair( std::string( myEntry[ k ].name ), k ));
+    }
+
+    entry& At( int slot ) const
+    {
+        if( 0 > slot || slot >= myCount )
+            throw std::runtime_error( "shared_store bad slot" );
+        return myEntry[ slot ];
+    }
+
+    entry& At( int slot, eSlot type ) const
+    {
+        entry& e = At( slot );
+        if( e.type != type )
+            throw std::runtime_error(
+                std::string( "shared_store wrong type for " ) + e.name );
+        return e;
+    }
+
+    void Write( entry& e, uint64_t bits )
+    {
+        e.value.store( bits, std::memory_order_relaxed );
+        e.seq.fetch_add( 1, std::memory_order_release );
+    }
+
+    uint64_t Read( const entry& e ) const
+    {
+        return e.value.load( std::memory_order_acquire );
+    }
+};
+
+}
+}